@@ -0,0 +1,354 @@
+// Compares the shared JSON scanner with the per-server helpers it replaced
+// (extractJsonValue / extractNestedObject), on captured stats payloads.
+// Reports heap allocations and nanoseconds per parse for each.
+
+#include "json-scan.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+
+} // anonymous namespace
+
+void *operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+using namespace BitrateSwitch;
+
+// ----------- the helpers every parser used to carry -----------
+namespace legacy {
+
+std::string extractJsonValue(const std::string &json, const std::string &key)
+{
+    std::string searchKey = "\"" + key + "\"";
+    size_t keyPos = json.find(searchKey);
+    if (keyPos == std::string::npos) return "";
+
+    size_t colonPos = json.find(':', keyPos);
+    if (colonPos == std::string::npos) return "";
+
+    size_t valueStart = json.find_first_not_of(" \t\n\r", colonPos + 1);
+    if (valueStart == std::string::npos) return "";
+
+    if (json[valueStart] == '"') {
+        size_t valueEnd = json.find('"', valueStart + 1);
+        if (valueEnd == std::string::npos) return "";
+        return json.substr(valueStart + 1, valueEnd - valueStart - 1);
+    }
+
+    size_t valueEnd = json.find_first_of(",}\n\r]", valueStart);
+    if (valueEnd == std::string::npos) valueEnd = json.length();
+
+    std::string value = json.substr(valueStart, valueEnd - valueStart);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+        value.pop_back();
+    return value;
+}
+
+std::string extractNestedObject(const std::string &json, const std::string &key)
+{
+    std::string searchKey = "\"" + key + "\"";
+    size_t keyPos = json.find(searchKey);
+    if (keyPos == std::string::npos) return "";
+
+    size_t bracePos = json.find('{', keyPos);
+    if (bracePos == std::string::npos) return "";
+
+    int depth = 1;
+    size_t endPos = bracePos + 1;
+    while (depth > 0 && endPos < json.length()) {
+        if (json[endPos] == '{') depth++;
+        else if (json[endPos] == '}') depth--;
+        endPos++;
+    }
+
+    return json.substr(bracePos, endPos - bracePos);
+}
+
+int64_t sls(const std::string &body, const std::string &publisher)
+{
+    std::string publishers = extractNestedObject(body, "publishers");
+    if (publishers.empty()) return 0;
+    std::string publisherData = extractNestedObject(publishers, publisher);
+    if (publisherData.empty()) return 0;
+
+    std::string bitrateStr = extractJsonValue(publisherData, "bitrate");
+    std::string rttStr = extractJsonValue(publisherData, "rtt");
+    std::string mbpsBwStr = extractJsonValue(publisherData, "mbps_bandwidth");
+    std::string mbpsRecvStr = extractJsonValue(publisherData, "mbps_recv_rate");
+    std::string pktDropStr = extractJsonValue(publisherData, "pkt_rcv_drop");
+    std::string bytesLostStr = extractJsonValue(publisherData, "bytes_rcv_loss");
+
+    int64_t bitrate = 0;
+    try {
+        if (!bitrateStr.empty()) bitrate = std::stoll(bitrateStr);
+        if (!rttStr.empty()) bitrate += static_cast<int64_t>(std::stod(rttStr));
+        if (!mbpsBwStr.empty()) bitrate += static_cast<int64_t>(std::stod(mbpsBwStr));
+        if (!mbpsRecvStr.empty()) bitrate += static_cast<int64_t>(std::stod(mbpsRecvStr));
+        if (!pktDropStr.empty()) bitrate += std::stoi(pktDropStr);
+        if (!bytesLostStr.empty()) bitrate += std::stoi(bytesLostStr);
+    } catch (...) {
+    }
+    return bitrate;
+}
+
+int64_t nimble(const std::string &srtBody, const std::string &rtmpBody, const std::string &id,
+               const std::string &app, const std::string &key)
+{
+    size_t idPos = srtBody.find("\"id\":\"" + id);
+    if (idPos == std::string::npos) return 0;
+
+    size_t statePos = srtBody.find("\"state\":", idPos);
+    if (statePos != std::string::npos) {
+        std::string stateBlock = srtBody.substr(statePos, 50);
+        if (stateBlock.find("disconnected") != std::string::npos)
+            return 0;
+    }
+
+    int64_t result = 0;
+    try {
+        std::string linkStats = extractNestedObject(srtBody.substr(idPos), "link");
+        if (!linkStats.empty()) {
+            std::string rttStr = extractJsonValue(linkStats, "rtt");
+            if (!rttStr.empty())
+                result += static_cast<int64_t>(std::stod(rttStr));
+        }
+
+        size_t appPos = rtmpBody.find("\"app\":\"" + app + "\"");
+        if (appPos != std::string::npos) {
+            size_t strmPos = rtmpBody.find("\"strm\":\"" + key + "\"", appPos);
+            if (strmPos != std::string::npos) {
+                size_t bwPos = rtmpBody.rfind("\"bandwidth\":", strmPos);
+                if (bwPos != std::string::npos && bwPos > appPos) {
+                    std::string bwStr = extractJsonValue(rtmpBody.substr(bwPos), "bandwidth");
+                    if (!bwStr.empty())
+                        result += std::stoll(bwStr) / 1024;
+                }
+            }
+        }
+    } catch (...) {
+    }
+    return result;
+}
+
+int64_t mediamtx(const std::string &body)
+{
+    if (extractJsonValue(body, "ready") != "true") return 0;
+
+    int64_t result = 0;
+    std::string sourceObj = extractNestedObject(body, "source");
+    if (!sourceObj.empty()) {
+        std::string sourceType = extractJsonValue(sourceObj, "type");
+        std::string sourceId = extractJsonValue(sourceObj, "id");
+        if (sourceType == "srtConn" && !sourceId.empty())
+            result += static_cast<int64_t>(sourceId.size());
+    }
+
+    std::string bytesReceivedStr = extractJsonValue(body, "bytesReceived");
+    if (bytesReceivedStr.empty()) return result;
+    try {
+        result += static_cast<int64_t>(std::stoull(bytesReceivedStr));
+    } catch (...) {
+    }
+    return result;
+}
+
+} // namespace legacy
+
+// ----------- the same parses on the shared scanner -----------
+namespace scanner {
+
+int64_t sls(std::string_view body, std::string_view publisher)
+{
+    JsonQuery fields[] = {
+        {"publishers", publisher, "bitrate"},
+        {"publishers", publisher, "rtt"},
+        {"publishers", publisher, "mbps_bandwidth"},
+        {"publishers", publisher, "mbps_recv_rate"},
+        {"publishers", publisher, "pkt_rcv_drop"},
+        {"publishers", publisher, "bytes_rcv_loss"},
+    };
+    jsonScan(body, fields);
+
+    int64_t bitrate = 0;
+    double number = 0.0;
+    int64_t count = 0;
+    jsonToInt(fields[0].value, bitrate);
+    for (size_t i = 1; i < 4; i++) {
+        if (jsonToDouble(fields[i].value, number))
+            bitrate += static_cast<int64_t>(number);
+    }
+    for (size_t i = 4; i < 6; i++) {
+        if (jsonToInt(fields[i].value, count))
+            bitrate += count;
+    }
+    return bitrate;
+}
+
+int64_t nimble(std::string_view srtBody, std::string_view rtmpBody, const std::string &id,
+               const std::string &app, const std::string &key)
+{
+    size_t idPos = srtBody.find("\"id\":\"" + id);
+    if (idPos == std::string_view::npos) return 0;
+
+    JsonQuery receiver[] = {{"state"}, {"link", "rtt"}};
+    jsonScan(srtBody.substr(idPos), receiver);
+    if (receiver[0].value.find("disconnected") != std::string_view::npos)
+        return 0;
+
+    int64_t result = 0;
+    double rtt = 0.0;
+    if (jsonToDouble(receiver[1].value, rtt))
+        result += static_cast<int64_t>(rtt);
+
+    size_t appPos = rtmpBody.find("\"app\":\"" + app + "\"");
+    if (appPos != std::string_view::npos) {
+        size_t strmPos = rtmpBody.find("\"strm\":\"" + key + "\"", appPos);
+        if (strmPos != std::string_view::npos) {
+            size_t bwPos = rtmpBody.rfind("\"bandwidth\":", strmPos);
+            if (bwPos != std::string_view::npos && bwPos > appPos) {
+                int64_t bw = 0;
+                if (jsonToInt(jsonFind(rtmpBody.substr(bwPos), {"bandwidth"}), bw))
+                    result += bw / 1024;
+            }
+        }
+    }
+    return result;
+}
+
+int64_t mediamtx(std::string_view body)
+{
+    JsonQuery fields[] = {
+        {"ready"},
+        {"source", "type"},
+        {"source", "id"},
+        {"bytesReceived"},
+    };
+    jsonScan(body, fields);
+    if (fields[0].value != "true") return 0;
+
+    int64_t result = 0;
+    if (fields[1].value == "srtConn" && !fields[2].value.empty())
+        result += static_cast<int64_t>(fields[2].value.size());
+
+    int64_t received = 0;
+    if (jsonToInt(fields[3].value, received))
+        result += received;
+    return result;
+}
+
+} // namespace scanner
+
+std::string readPayload(const char *name)
+{
+    std::string path = std::string(BENCH_PAYLOAD_DIR) + "/" + name;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "missing payload %s\n", path.c_str());
+        std::exit(1);
+    }
+    std::ostringstream body;
+    body << in.rdbuf();
+    return body.str();
+}
+
+// Keeps results observable so the parses aren't optimized away
+volatile int64_t g_sink = 0;
+
+struct Result {
+    double nsPerParse = 0.0;
+    double allocsPerParse = 0.0;
+    int64_t value = 0;
+};
+
+template <typename Fn>
+Result measure(int iterations, Fn fn)
+{
+    // warm up caches and any lazy state first
+    for (int i = 0; i < iterations / 10; i++)
+        g_sink = fn();
+
+    Result result;
+    uint64_t allocsBefore = g_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        g_sink = fn();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    uint64_t allocs = g_allocations.load() - allocsBefore;
+
+    result.nsPerParse =
+        static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+        iterations;
+    result.allocsPerParse = static_cast<double>(allocs) / iterations;
+    result.value = g_sink;
+    return result;
+}
+
+bool report(const char *payload, const Result &before, const Result &after)
+{
+    std::printf("%-10s legacy %8.1f ns %6.1f allocs | scanner %8.1f ns %6.1f allocs | %.1fx\n",
+                payload, before.nsPerParse, before.allocsPerParse, after.nsPerParse,
+                after.allocsPerParse, before.nsPerParse / after.nsPerParse);
+    if (before.value != after.value) {
+        std::printf("%-10s MISMATCH: legacy %lld, scanner %lld\n", payload,
+                    static_cast<long long>(before.value), static_cast<long long>(after.value));
+        return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    if (iterations <= 0)
+        iterations = 200000;
+
+    const std::string sls = readPayload("sls-stats.json");
+    const std::string nimbleSrt = readPayload("nimble-srt-receiver-stats.json");
+    const std::string nimbleRtmp = readPayload("nimble-rtmp-status.json");
+    const std::string mediamtx = readPayload("mediamtx-paths-get.json");
+
+    const std::string publisher = "live/feed1";
+    const std::string id = "0a1b2c3d-0002";
+    const std::string app = "live";
+    const std::string key = "feed1";
+
+    bool ok = true;
+    ok &= report("sls",
+                 measure(iterations, [&] { return legacy::sls(sls, publisher); }),
+                 measure(iterations, [&] { return scanner::sls(sls, publisher); }));
+    ok &= report("nimble",
+                 measure(iterations, [&] { return legacy::nimble(nimbleSrt, nimbleRtmp, id, app, key); }),
+                 measure(iterations, [&] { return scanner::nimble(nimbleSrt, nimbleRtmp, id, app, key); }));
+    ok &= report("mediamtx",
+                 measure(iterations, [&] { return legacy::mediamtx(mediamtx); }),
+                 measure(iterations, [&] { return scanner::mediamtx(mediamtx); }));
+    return ok ? 0 : 1;
+}
@@ -3,8 +3,18 @@
 #include <obs-module.h>
 #include <obs-frontend-api.h>
 #include <algorithm>
+#include <cerrno>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <map>
 #include <utility>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
 
 namespace BitrateSwitch {
 
@@ -21,8 +31,299 @@ struct ChatCmdPack {
 // winsock init is handled by curl_global_init in plugin-main,
 // no need to mess with WSAStartup/WSACleanup here
 
+namespace {
+
+struct Address {
+    sockaddr_storage addr{};
+    socklen_t len = 0;
+    int family = AF_UNSPEC;
+};
+
+// a good answer is reused this long; a stale one still beats a failed lookup
+constexpr auto kResolveTtl = std::chrono::minutes(5);
+
+// how often waits re-check for disconnect()
+constexpr int kWaitSliceMs = 50;
+
+// unsent output allowed to queue up behind a full socket buffer before
+// the connection counts as stuck
+constexpr size_t kMaxOutbox = 65536;
+
+#ifdef MSG_NOSIGNAL
+// a peer reset surfaces as an error, not SIGPIPE
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+// how long shutdown waits for a lookup in progress before leaving it behind
+constexpr auto kResolverShutdownWait = std::chrono::milliseconds(100);
+
+// Keeps this plugin's image mapped until the process exits, even after OBS
+// unloads it. A lookup thread left running still has plugin code to return
+// into.
+void pinModule()
+{
+    static const char anchor = 0;
+#ifdef _WIN32
+    HMODULE module = nullptr;
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+                            reinterpret_cast<LPCWSTR>(&anchor), &module))
+        blog(LOG_WARNING, "[BitrateSceneSwitch] Chat: could not pin module (%lu)", GetLastError());
+#else
+    Dl_info info{};
+    // RTLD_NOLOAD only finds the loaded image; RTLD_NODELETE then keeps
+    // it past OBS's dlclose. The extra reference is never dropped.
+    if (!dladdr(&anchor, &info) || !info.dli_fname ||
+        !dlopen(info.dli_fname, RTLD_NOW | RTLD_NOLOAD | RTLD_NODELETE))
+        blog(LOG_WARNING, "[BitrateSceneSwitch] Chat: could not pin module");
+#endif
+}
+
+// getaddrinfo can't be cancelled, so it runs on one long-lived thread of
+// its own. Callers wait with a timeout and get cached addresses, so a hung
+// DNS server never holds up a connect attempt or a disconnect.
+//
+// The thread shares its state rather than pointing back at the Resolver:
+// shutdown only waits briefly for a lookup to finish and otherwise detaches
+// it, so a hung getaddrinfo can't hold up plugin unload either. A detached
+// lookup pins the plugin in memory so it has code to return into, and its
+// result is dropped without logging.
+class Resolver {
+public:
+    ~Resolver() { shutdown(); }
+
+    // Idempotent; later resolve() calls find nothing
+    void shutdown()
+    {
+        std::shared_ptr<State> state = state_;
+        std::unique_lock<std::mutex> lock(state->mutex);
+        if (state->stopping)
+            return;
+        state->stopping = true;
+        state->cv.notify_all();
+        bool idle = state->cv.wait_for(lock, kResolverShutdownWait,
+                                       [&] { return !state->threadRunning; });
+        lock.unlock();
+
+        if (!thread_.joinable())
+            return;
+        if (idle) {
+            thread_.join();
+        } else {
+            pinModule();
+            thread_.detach();
+        }
+    }
+
+    // Empty when nothing was found in time, or on cancel
+    std::vector<Address> resolve(const std::string &host, int port,
+                                 std::chrono::milliseconds timeout,
+                                 const std::atomic<bool> &running)
+    {
+        std::string key = host + ":" + std::to_string(port);
+        auto start = std::chrono::steady_clock::now();
+
+        State &state = *state_;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        if (state.stopping)
+            return {};
+        Entry &entry = state.cache[key];
+        if (!entry.addresses.empty() && start - entry.resolvedAt < kResolveTtl)
+            return entry.addresses;
+
+        if (!entry.pending) {
+            entry.pending = true;
+            state.queue.push_back(Request{key, host, port});
+            if (!state.threadRunning) {
+                state.threadRunning = true;
+                thread_ = std::thread(&Resolver::run, state_);
+            }
+            state.cv.notify_all();
+        }
+
+        auto deadline = start + timeout;
+        while (entry.pending && running && !state.stopping &&
+               std::chrono::steady_clock::now() < deadline)
+            state.cv.wait_for(lock, std::chrono::milliseconds(kWaitSliceMs));
+
+        if (entry.pending && !entry.addresses.empty())
+            blog(LOG_WARNING, "[BitrateSceneSwitch] Chat: DNS slow for %s, using cached addresses",
+                 host.c_str());
+        return entry.addresses;
+    }
+
+private:
+    struct Entry {
+        std::vector<Address> addresses;
+        std::chrono::steady_clock::time_point resolvedAt;
+        bool pending = false;
+    };
+
+    struct Request {
+        std::string key;
+        std::string host;
+        int port = 0;
+    };
+
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::map<std::string, Entry> cache;
+        std::deque<Request> queue;
+        bool stopping = false;
+        bool threadRunning = false;
+    };
+
+    static void run(std::shared_ptr<State> state)
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        for (;;) {
+            state->cv.wait(lock, [&] { return state->stopping || !state->queue.empty(); });
+            if (state->stopping)
+                break;
+            Request request = std::move(state->queue.front());
+            state->queue.pop_front();
+            lock.unlock();
+
+            std::vector<Address> found = lookup(request.host, request.port);
+
+            lock.lock();
+            if (state->stopping)
+                break;
+            Entry &entry = state->cache[request.key];
+            entry.pending = false;
+            if (!found.empty()) {
+                entry.addresses = std::move(found);
+                entry.resolvedAt = std::chrono::steady_clock::now();
+            } else {
+                blog(LOG_WARNING, "[BitrateSceneSwitch] Chat: Failed to resolve host %s",
+                     request.host.c_str());
+            }
+            state->cv.notify_all();
+        }
+        state->threadRunning = false;
+        state->cv.notify_all();
+    }
+
+    // Both families, alternating (RFC 8305) and starting with whichever
+    // the system prefers
+    static std::vector<Address> lookup(const std::string &host, int port)
+    {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *result = nullptr;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0)
+            return {};
+
+        std::vector<Address> first, second;
+        int preferred = result ? result->ai_family : AF_UNSPEC;
+        for (addrinfo *ai = result; ai; ai = ai->ai_next) {
+            if (ai->ai_addrlen > sizeof(sockaddr_storage))
+                continue;
+            Address address;
+            memcpy(&address.addr, ai->ai_addr, ai->ai_addrlen);
+            address.len = static_cast<socklen_t>(ai->ai_addrlen);
+            address.family = ai->ai_family;
+            (ai->ai_family == preferred ? first : second).push_back(address);
+        }
+        freeaddrinfo(result);
+
+        std::vector<Address> ordered;
+        for (size_t i = 0; i < first.size() || i < second.size(); i++) {
+            if (i < first.size())
+                ordered.push_back(first[i]);
+            if (i < second.size())
+                ordered.push_back(second[i]);
+        }
+        return ordered;
+    }
+
+    std::shared_ptr<State> state_ = std::make_shared<State>();
+    std::thread thread_;
+};
+
+Resolver &resolver()
+{
+    static Resolver instance;
+    return instance;
+}
+
+void setNonBlocking(SOCKET s, bool on)
+{
+#ifdef _WIN32
+    u_long mode = on ? 1 : 0;
+    ioctlsocket(s, FIONBIO, &mode);
+#else
+    int flags = fcntl(s, F_GETFL);
+    fcntl(s, F_SETFL, on ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+#endif
+}
+
+bool connectPending()
+{
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EINPROGRESS;
+#endif
+}
+
+bool sendWouldBlock()
+{
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+bool sendInterrupted()
+{
+#ifdef _WIN32
+    return false;
+#else
+    return errno == EINTR;
+#endif
+}
+
+int lastSocketError()
+{
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+int socketError(SOCKET s)
+{
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(s, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&err), &len) != 0)
+        return -1;
+    return err;
+}
+
+int pollSockets(std::vector<pollfd> &fds, int timeoutMs)
+{
+#ifdef _WIN32
+    return WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeoutMs);
+#else
+    return poll(fds.data(), static_cast<nfds_t>(fds.size()), timeoutMs);
+#endif
+}
+
+} // anonymous namespace
+
 ChatClient::ChatClient() = default;
 
+void ChatClient::shutdownResolver()
+{
+    resolver().shutdown();
+}
+
 ChatClient::~ChatClient()
 {
     disconnect();
@@ -44,51 +345,41 @@ void ChatClient::setRoomIdCallback(std::function<void(const std::string &)> cb)
     roomIdSent_ = false;
 }
 
+void ChatClient::setStateCallback(std::function<void()> cb)
+{
+    stateCallback_ = std::move(cb);
+}
+
 bool ChatClient::connect()
 {
-    if (connected_) return true;
+    if (connected_ || connecting_) return true;
     if (config_.channel.empty() || config_.oauthToken.empty()) {
         blog(LOG_WARNING, "[BitrateSceneSwitch] Chat: Missing channel or OAuth token");
         return false;
     }
-    
-    const char* host = TWITCH_IRC_HOST;
-    int port = TWITCH_IRC_PORT;
-    
-    struct addrinfo hints{}, *result;
-    hints.ai_family = AF_INET;
-    hints.ai_socktype = SOCK_STREAM;
-    
-    if (getaddrinfo(host, std::to_string(port).c_str(), &hints, &result) != 0) {
-        blog(LOG_ERROR, "[BitrateSceneSwitch] Chat: Failed to resolve host %s", host);
-        return false;
-    }
-    
-    socket_ = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
-    if (socket_ == INVALID_SOCKET) {
-        freeaddrinfo(result);
-        blog(LOG_ERROR, "[BitrateSceneSwitch] Chat: Failed to create socket");
-        return false;
+
+    // a previous attempt that ended on its own
+    disconnect();
+
+    running_ = true;
+    connecting_ = true;
+    worker_ = std::thread(&ChatClient::workerMain, this);
+    return true;
+}
+
+void ChatClient::workerMain()
+{
+    SOCKET s = openSocket();
+    if (s == INVALID_SOCKET) {
+        endSession();
+        return;
     }
-    
-    if (::connect(socket_, result->ai_addr, (int)result->ai_addrlen) == SOCKET_ERROR) {
-        freeaddrinfo(result);
-        closesocket(socket_);
-        socket_ = INVALID_SOCKET;
-        blog(LOG_ERROR, "[BitrateSceneSwitch] Chat: Failed to connect to %s:%d", host, port);
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        socket_ = s;
+        outbox_.clear();
+        sendFailed_ = false;
     }
-    
-    freeaddrinfo(result);
-
-    // Set recv timeout so the receive thread can check running_ periodically
-#ifdef _WIN32
-    DWORD rcvTimeout = 5000;
-    setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, (const char *)&rcvTimeout, sizeof(rcvTimeout));
-#else
-    struct timeval rcvTimeout = {5, 0};
-    setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &rcvTimeout, sizeof(rcvTimeout));
-#endif
 
     std::string username = config_.botUsername.empty() ? config_.channel : config_.botUsername;
     std::transform(username.begin(), username.end(), username.begin(), ::tolower);
@@ -98,29 +389,182 @@ bool ChatClient::connect()
     sendRaw("JOIN #" + config_.channel + "\r\n");
     sendRaw("CAP REQ :twitch.tv/commands twitch.tv/tags\r\n");
     
-    connected_ = true;
-    running_ = true;
-    lastTrafficTime_ = std::chrono::steady_clock::now();
-    lastPingSent_ = lastTrafficTime_;
-    receiveThread_ = std::thread(&ChatClient::receiveLoop, this);
-    
-    blog(LOG_INFO, "[BitrateSceneSwitch] Chat: Connected to Twitch channel #%s", config_.channel.c_str());
-    
-    return true;
+    loginSent_ = std::chrono::steady_clock::now();
+    lastTrafficTime_ = loginSent_;
+    lastPingSent_ = loginSent_;
+    pending_.clear();
+
+#ifdef _WIN32
+    // blocking reads with a timeout so the liveness check still runs
+    setNonBlocking(socket_, false);
+    DWORD rcvTimeout = LIVENESS_CHECK_SEC * 1000;
+    setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, (const char *)&rcvTimeout, sizeof(rcvTimeout));
+    while (running_ && readAvailable() && checkLiveness()) {
+    }
+#else
+    // the reactor drains whatever is there and goes back to waiting;
+    // the socket stays open until disconnect() so its number can't be
+    // reused while the reactor still watches it
+    if (!running_)
+        return;
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    reactor_ = NetReactor::shared();
+    reactorId_ = reactor_->add(
+        socket_, [this] { return readAvailable(); }, [this] { return checkLiveness(); },
+        std::chrono::seconds(LIVENESS_CHECK_SEC),
+        [this] { return flushOutbox() || endSession(); });
+    if (reactorId_ == 0) {
+        reactor_.reset();
+        endSession();
+        return;
+    }
+    // the login may already be queued behind a full socket
+    watchingWritable_ = false;
+    watchWritableLocked(!outbox_.empty());
+#endif
+}
+
+SOCKET ChatClient::openSocket()
+{
+    const char* host = config_.twitchIrcHost.c_str();
+    int port = config_.twitchIrcPort;
+
+    std::vector<Address> addresses = resolver().resolve(
+        host, port, std::chrono::seconds(RESOLVE_TIMEOUT_SEC), running_);
+    if (addresses.empty()) {
+        if (running_)
+            blog(LOG_ERROR, "[BitrateSceneSwitch] Chat: No address for %s", host);
+        return INVALID_SOCKET;
+    }
+
+    // Happy eyeballs: a new address is tried every NEXT_ADDRESS_DELAY_MS
+    // (or as soon as one fails) without giving up on the earlier ones;
+    // the first to connect wins
+    struct Attempt {
+        SOCKET s;
+        int family;
+    };
+    std::vector<Attempt> attempts;
+    SOCKET winner = INVALID_SOCKET;
+    int winnerFamily = AF_UNSPEC;
+    size_t next = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(CONNECT_TIMEOUT_SEC);
+    auto nextStart = std::chrono::steady_clock::now();
+
+    while (running_ && winner == INVALID_SOCKET) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            break;
+
+        if (next < addresses.size() && now >= nextStart) {
+            const Address &address = addresses[next++];
+            nextStart = now + std::chrono::milliseconds(NEXT_ADDRESS_DELAY_MS);
+            SOCKET s = socket(address.family, SOCK_STREAM, IPPROTO_TCP);
+            if (s == INVALID_SOCKET) {
+                nextStart = now;
+                continue;
+            }
+            setNonBlocking(s, true);
+            if (::connect(s, reinterpret_cast<const sockaddr *>(&address.addr), address.len) == 0) {
+                winner = s;
+                winnerFamily = address.family;
+            } else if (connectPending()) {
+                attempts.push_back(Attempt{s, address.family});
+            } else {
+                closesocket(s);
+                nextStart = now;
+            }
+            continue;
+        }
+        if (attempts.empty()) {
+            if (next >= addresses.size())
+                break;
+            continue;
+        }
+
+        auto until = next < addresses.size() ? (std::min)(nextStart, deadline) : deadline;
+        auto waitMs = std::chrono::ceil<std::chrono::milliseconds>(until - now).count();
+        std::vector<pollfd> fds;
+        for (const Attempt &attempt : attempts)
+            fds.push_back(pollfd{attempt.s, POLLOUT, 0});
+        // WSAPoll may never flag a refused connect; the deadline covers it
+        int ready = pollSockets(fds, static_cast<int>((std::min)(waitMs, static_cast<decltype(waitMs)>(kWaitSliceMs))));
+        if (ready <= 0)
+            continue;
+
+        for (size_t i = fds.size(); i-- > 0;) {
+            if (!fds[i].revents)
+                continue;
+            if (winner == INVALID_SOCKET && socketError(attempts[i].s) == 0) {
+                winner = attempts[i].s;
+                winnerFamily = attempts[i].family;
+            } else {
+                closesocket(attempts[i].s);
+                nextStart = now;
+            }
+            attempts.erase(attempts.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+
+    for (const Attempt &attempt : attempts)
+        closesocket(attempt.s);
+
+    if (winner == INVALID_SOCKET) {
+        if (running_)
+            blog(LOG_ERROR, "[BitrateSceneSwitch] Chat: Failed to connect to %s:%d", host, port);
+        return INVALID_SOCKET;
+    }
+    if (!running_) {
+        closesocket(winner);
+        return INVALID_SOCKET;
+    }
+
+    blog(LOG_INFO, "[BitrateSceneSwitch] Chat: TCP connected to %s over %s", host,
+         winnerFamily == AF_INET6 ? "IPv6" : "IPv4");
+    return winner;
 }
 
 void ChatClient::disconnect()
 {
     bool wasConnected = connected_.exchange(false);
+    connecting_ = false;
     running_ = false;
-    
-    if (socket_ != INVALID_SOCKET) {
-        closesocket(socket_);
-        socket_ = INVALID_SOCKET;
+
+#ifdef _WIN32
+    // shutdown wakes a recv blocked on the worker right away; the
+    // descriptor is only closed once that thread is gone so its number
+    // can't be reused under it
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        if (socket_ != INVALID_SOCKET)
+            shutdown(socket_, SD_BOTH);
     }
-    
-    if (receiveThread_.joinable()) {
-        receiveThread_.join();
+    if (worker_.joinable())
+        worker_.join();
+#else
+    // the worker notices running_ within one wait slice; then stop the
+    // reactor watching before closing
+    if (worker_.joinable())
+        worker_.join();
+    std::shared_ptr<NetReactor> reactor;
+    NetReactor::Id reactorId = 0;
+    {
+        // sendRaw() on another thread may be arming write interest
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        reactor = std::move(reactor_);
+        reactorId = reactorId_;
+        reactorId_ = 0;
+    }
+    if (reactor)
+        reactor->remove(reactorId);
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        if (socket_ != INVALID_SOCKET) {
+            closesocket(socket_);
+            socket_ = INVALID_SOCKET;
+        }
     }
     
     if (wasConnected)
@@ -132,82 +576,136 @@ bool ChatClient::isConnected() const
     return connected_;
 }
 
+bool ChatClient::isConnecting() const
+{
+    return connecting_;
+}
+
 void ChatClient::sendMessage(const std::string& message)
 {
     if (!connected_ || config_.channel.empty()) return;
     sendRaw("PRIVMSG #" + config_.channel + " :" + message + "\r\n");
 }
 
-void ChatClient::receiveLoop()
+bool ChatClient::endSession()
+{
+    bool wasUp = connected_.exchange(false);
+    bool wasConnecting = connecting_.exchange(false);
+    if ((wasUp || wasConnecting) && running_ && stateCallback_)
+        stateCallback_();
+    return false;
+}
+
+// Twitch answers a good login with 001 and a bad one with a NOTICE
+bool ChatClient::checkLogin(const std::string &line)
+{
+    if (line.find(" 001 ") != std::string::npos) {
+        connected_ = true;
+        connecting_ = false;
+        blog(LOG_INFO, "[BitrateSceneSwitch] Chat: Connected to Twitch channel #%s", config_.channel.c_str());
+        if (stateCallback_)
+            stateCallback_();
+        return true;
+    }
+    if (line.find("NOTICE * :") != std::string::npos &&
+        (line.find("Login authentication failed") != std::string::npos ||
+         line.find("Improperly formatted auth") != std::string::npos)) {
+        blog(LOG_ERROR, "[BitrateSceneSwitch] Chat: Twitch rejected the login, check the OAuth token");
+        return false;
+    }
+    return true;
+}
+
+bool ChatClient::readAvailable()
 {
     char buffer[4096];
-    std::string pending;
+
+    if (!flushOutbox())
+        return endSession();
 
     while (running_) {
         int received = recv(socket_, buffer, sizeof(buffer) - 1, 0);
         if (received > 0) {
             lastTrafficTime_ = std::chrono::steady_clock::now();
             buffer[received] = '\0';
-            pending += buffer;
+            pending_ += buffer;
 
             // bounded so a malformed peer can't OOM us over weeks of uptime
-            if (pending.size() > 65536) {
+            if (pending_.size() > 65536) {
                 blog(LOG_WARNING,
                      "[BitrateSceneSwitch] Chat: pending buffer overrun, resetting");
-                pending.clear();
+                pending_.clear();
             }
 
             size_t pos;
-            while ((pos = pending.find("\r\n")) != std::string::npos) {
-                std::string line = pending.substr(0, pos);
-                pending = pending.substr(pos + 2);
+            while ((pos = pending_.find("\r\n")) != std::string::npos) {
+                std::string line = pending_.substr(0, pos);
+                pending_ = pending_.substr(pos + 2);
+                if (!connected_ && !checkLogin(line))
+                    return endSession();
                 handleMessage(line);
             }
-        } else if (received == 0) {
-            blog(LOG_WARNING, "[BitrateSceneSwitch] Chat: Connection closed by peer");
-            connected_ = false;
-            break;
-        } else {
+            continue;
+        }
+        if (received == 0) {
             if (!running_)
-                break;
+                return false;
+            blog(LOG_WARNING, "[BitrateSceneSwitch] Chat: Connection closed by peer");
+            return endSession();
+        }
+        if (!running_)
+            return false;
+
+        // nothing more to read for now
 #ifdef _WIN32
-            int e = WSAGetLastError();
-            if (e != WSAETIMEDOUT) {
-                blog(LOG_WARNING,
-                     "[BitrateSceneSwitch] Chat: recv error %d", e);
-                connected_ = false;
-                break;
-            }
+        int e = WSAGetLastError();
+        if (e == WSAETIMEDOUT)
+            return true;
 #else
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                blog(LOG_WARNING,
-                     "[BitrateSceneSwitch] Chat: recv error %d", errno);
-                connected_ = false;
-                break;
-            }
+        int e = errno;
+        if (e == EAGAIN || e == EWOULDBLOCK)
+            return true;
+        if (e == EINTR)
+            continue;
 #endif
-        }
+        blog(LOG_WARNING, "[BitrateSceneSwitch] Chat: recv error %d", e);
+        return endSession();
+    }
+    return false;
+}
 
-        // liveness check: twitch pings ~every 5min. if we've heard nothing
-        // for 6min we're talking to a dead socket and need to reconnect.
-        // proactively send our own PING at 4min so a dead send surfaces fast.
-        auto now = std::chrono::steady_clock::now();
-        auto silentSec = std::chrono::duration_cast<std::chrono::seconds>(
-            now - lastTrafficTime_).count();
-        if (silentSec >= LIVENESS_TIMEOUT_SEC) {
-            blog(LOG_WARNING,
-                 "[BitrateSceneSwitch] Chat: no traffic for %llds, declaring dead",
-                 (long long)silentSec);
-            connected_ = false;
-            break;
-        }
-        auto sincePing = std::chrono::duration_cast<std::chrono::seconds>(
-            now - lastPingSent_).count();
-        if (sincePing >= PROACTIVE_PING_SEC) {
-            sendRaw("PING :tmi.twitch.tv\r\n");
-            lastPingSent_ = now;
-        }
+bool ChatClient::checkLiveness()
+{
+    // twitch pings ~every 5min. if we've heard nothing for 6min we're
+    // talking to a dead socket and need to reconnect. proactively send
+    // our own PING at 4min so a dead send surfaces fast.
+    if (!flushOutbox())
+        return endSession();
+
+    auto now = std::chrono::steady_clock::now();
+    if (!connected_) {
+        if (now - loginSent_ < std::chrono::seconds(LOGIN_TIMEOUT_SEC))
+            return true;
+        blog(LOG_WARNING, "[BitrateSceneSwitch] Chat: no answer to login after %ds",
+             LOGIN_TIMEOUT_SEC);
+        return endSession();
     }
+
+    auto silentSec = std::chrono::duration_cast<std::chrono::seconds>(
+        now - lastTrafficTime_).count();
+    if (silentSec >= LIVENESS_TIMEOUT_SEC) {
+        blog(LOG_WARNING,
+             "[BitrateSceneSwitch] Chat: no traffic for %llds, declaring dead",
+             (long long)silentSec);
+        return endSession();
+    }
+    auto sincePing = std::chrono::duration_cast<std::chrono::seconds>(
+        now - lastPingSent_).count();
+    if (sincePing >= PROACTIVE_PING_SEC) {
+        sendRaw("PING :tmi.twitch.tv\r\n");
+        lastPingSent_ = now;
+    }
+    return true;
 }
 
 void ChatClient::extractRoomIdFromTags(const std::string &raw)
@@ -376,9 +874,59 @@ bool ChatClient::isAdmin(const std::string& username)
 void ChatClient::sendRaw(const std::string& data)
 {
     std::lock_guard<std::mutex> lock(sendMutex_);
-    if (socket_ != INVALID_SOCKET) {
-        send(socket_, data.c_str(), (int)data.length(), 0);
+    if (socket_ == INVALID_SOCKET || sendFailed_)
+        return;
+    // lines queued behind a full socket go out first, so nothing is
+    // reordered or cut in half
+    outbox_ += data;
+    flushLocked();
+}
+
+bool ChatClient::flushOutbox()
+{
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    if (!sendFailed_)
+        flushLocked();
+    return !sendFailed_;
+}
+
+void ChatClient::flushLocked()
+{
+    while (!outbox_.empty()) {
+        int sent = send(socket_, outbox_.data(), (int)outbox_.size(), kSendFlags);
+        if (sent > 0) {
+            outbox_.erase(0, static_cast<size_t>(sent));
+            continue;
+        }
+        if (sent < 0 && sendInterrupted())
+            continue;
+        if (sent < 0 && sendWouldBlock()) {
+            // the rest goes out as soon as the socket can take it
+            if (outbox_.size() <= kMaxOutbox) {
+                watchWritableLocked(true);
+                return;
+            }
+            blog(LOG_WARNING, "[BitrateSceneSwitch] Chat: send buffer full, dropping connection");
+        } else {
+            blog(LOG_WARNING, "[BitrateSceneSwitch] Chat: send error %d", lastSocketError());
+        }
+        outbox_.clear();
+        sendFailed_ = true;
+        break;
     }
+    watchWritableLocked(false);
+}
+
+void ChatClient::watchWritableLocked(bool on)
+{
+#ifndef _WIN32
+    if (!reactor_ || reactorId_ == 0 || watchingWritable_ == on)
+        return;
+    watchingWritable_ = on;
+    reactor_->watchWritable(reactorId_, on);
+#else
+    (void)on; // the worker's blocking socket waits in send() instead
+#endif
 }
 
 } // namespace BitrateSwitch
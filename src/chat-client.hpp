@@ -1,7 +1,9 @@
 #pragma once
 
 #include "config.hpp"
+#include "net-reactor.hpp"
 #include <chrono>
+#include <memory>
 #include <string>
 #include <functional>
 #include <thread>
@@ -18,6 +20,8 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
 #define SOCKET int
 #define INVALID_SOCKET -1
 #define SOCKET_ERROR -1
@@ -58,45 +62,94 @@ public:
     void setConfig(const ChatConfig& config);
     void setCommandCallback(CommandCallback callback);
     void setRoomIdCallback(std::function<void(const std::string &)> cb);
+    // Called from a network thread when an attempt succeeds or fails and
+    // when a connection drops
+    void setStateCallback(std::function<void()> cb);
     
+    // Starts connecting in the background and returns right away; false
+    // only when the config can't work. isConnected() turns true once
+    // Twitch has accepted the login.
     bool connect();
     void disconnect();
     bool isConnected() const;
+    bool isConnecting() const;
     
     void sendMessage(const std::string& message);
 
+    // Stops the shared DNS lookup thread for plugin unload, leaving a
+    // lookup that is stuck in getaddrinfo behind (with the plugin pinned
+    // in memory) instead of waiting on it
+    static void shutdownResolver();
+
     static ChatCommand parseCommandForConfig(const ChatConfig &cfg, const std::string &message,
                                              std::string &args);
     
 private:
-    void receiveLoop();
+    // Resolves, connects and logs in, then hands the session to the
+    // network reactor (or keeps running it on Windows)
+    void workerMain();
+    SOCKET openSocket();
+
+    // Session handlers, run on the network reactor (the worker on
+    // Windows); false means the connection is gone
+    bool readAvailable();
+    bool checkLiveness();
+    bool checkLogin(const std::string &line);
+    bool endSession();
     void handleMessage(const std::string& raw);
     ChatMessage parseMessage(const std::string& raw);
     ChatCommand parseCommand(const std::string& message, std::string& args);
     bool isAdmin(const std::string& username);
+    // Queues a line and writes as much as the socket takes; the rest is
+    // written from the reactor once the socket is writable again. A send
+    // error or a backlog that won't drain marks the session failed; the
+    // handlers notice through flushOutbox() and end it.
     void sendRaw(const std::string& data);
+    bool flushOutbox();
+    void flushLocked();
+    void watchWritableLocked(bool on);
     void extractRoomIdFromTags(const std::string &raw);
     
     ChatConfig config_;
     CommandCallback callback_;
     std::function<void(const std::string &)> roomIdCallback_;
     bool roomIdSent_ = false;
+    std::function<void()> stateCallback_;
     
     SOCKET socket_ = INVALID_SOCKET;
-    std::thread receiveThread_;
+    std::thread worker_;
+#ifndef _WIN32
+    // set by the worker, cleared by disconnect(); guarded by sendMutex_
+    std::shared_ptr<NetReactor> reactor_;
+    NetReactor::Id reactorId_ = 0;
+    bool watchingWritable_ = false;
+#endif
+    std::string pending_; // partial line carried between reads
     std::atomic<bool> running_{false};
     std::atomic<bool> connected_{false};
+    std::atomic<bool> connecting_{false};
     std::mutex sendMutex_;
+    std::string outbox_; // unsent output, guarded by sendMutex_
+    bool sendFailed_ = false; // guarded by sendMutex_
     
+    std::chrono::steady_clock::time_point loginSent_;
     std::chrono::steady_clock::time_point lastTrafficTime_;
     std::chrono::steady_clock::time_point lastPingSent_;
 
-    static constexpr const char* TWITCH_IRC_HOST = "irc.chat.twitch.tv";
-    static constexpr int TWITCH_IRC_PORT = 6667;
+    // each phase of connecting is bounded: DNS, TCP (across all
+    // addresses) and the wait for Twitch to accept the login
+    static constexpr int RESOLVE_TIMEOUT_SEC = 5;
+    static constexpr int CONNECT_TIMEOUT_SEC = 10;
+    static constexpr int LOGIN_TIMEOUT_SEC = 10;
+    // happy eyeballs: start the next address if this one hasn't
+    // connected yet
+    static constexpr int NEXT_ADDRESS_DELAY_MS = 250;
     // twitch sends server PING ~5min; declare dead at 6min of silence
     static constexpr int LIVENESS_TIMEOUT_SEC = 360;
     // proactively ping every 4min so a dead socket fails the send
     static constexpr int PROACTIVE_PING_SEC = 240;
+    // how often the above are checked
+    static constexpr int LIVENESS_CHECK_SEC = 5;
 };
 
 } // namespace BitrateSwitch
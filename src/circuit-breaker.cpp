@@ -0,0 +1,97 @@
+#include "circuit-breaker.hpp"
+#include <algorithm>
+
+namespace BitrateSwitch {
+
+namespace {
+
+// consecutive failed polls before we stop hammering a server
+constexpr uint32_t kFailureThreshold = 3;
+constexpr auto kMinBackoff = std::chrono::milliseconds(2000);
+constexpr auto kMaxBackoff = std::chrono::milliseconds(60000);
+// +/- this share of the backoff, so servers that died together don't
+// get probed in lockstep
+constexpr double kJitter = 0.2;
+
+int64_t toNs(std::chrono::steady_clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+} // anonymous namespace
+
+CircuitBreaker::CircuitBreaker()
+    : backoff_(kMinBackoff)
+    , rng_(static_cast<std::minstd_rand::result_type>(
+          toNs(std::chrono::steady_clock::now()) ^ reinterpret_cast<uintptr_t>(this)))
+{
+}
+
+bool CircuitBreaker::allow(std::chrono::steady_clock::time_point now)
+{
+    switch (state()) {
+    case State::Closed:
+        return true;
+    case State::Open:
+        if (toNs(now) < openUntilNs_.load())
+            return false;
+        state_ = static_cast<int>(State::HalfOpen);
+        probing_ = false;
+        [[fallthrough]];
+    case State::HalfOpen:
+        // one probe at a time
+        if (probing_)
+            return false;
+        probing_ = true;
+        return true;
+    }
+    return true;
+}
+
+void CircuitBreaker::recordSuccess()
+{
+    failures_ = 0;
+    backoff_ = kMinBackoff;
+    probing_ = false;
+    state_ = static_cast<int>(State::Closed);
+}
+
+void CircuitBreaker::recordFailure(std::chrono::steady_clock::time_point now)
+{
+    uint32_t failures = ++failures_;
+    bool probeFailed = state() == State::HalfOpen;
+    probing_ = false;
+
+    if (!probeFailed && failures < kFailureThreshold)
+        return;
+
+    if (probeFailed)
+        backoff_ = (std::min)(backoff_ * 2, std::chrono::milliseconds(kMaxBackoff));
+
+    std::uniform_real_distribution<double> jitter(1.0 - kJitter, 1.0 + kJitter);
+    auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(backoff_ * jitter(rng_));
+    openUntilNs_ = toNs(now) + delay.count();
+    state_ = static_cast<int>(State::Open);
+}
+
+CircuitBreaker::Snapshot CircuitBreaker::snapshot(std::chrono::steady_clock::time_point now) const
+{
+    Snapshot snap;
+    snap.state = state();
+    snap.failures = failures_.load();
+    if (snap.state == State::Open)
+        snap.retryInMs = (std::max)(int64_t(0), (openUntilNs_.load() - toNs(now)) / 1000000);
+    return snap;
+}
+
+const char *CircuitBreaker::stateName(State state)
+{
+    switch (state) {
+    case State::Closed: return "closed";
+    case State::Open: return "open";
+    case State::HalfOpen: return "half-open";
+    }
+    return "closed";
+}
+
+} // namespace BitrateSwitch
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+namespace BitrateSwitch {
+
+// Per-server health gate for stats polling. After a few consecutive failed
+// polls the breaker opens and the server is left alone for a backoff that
+// doubles (with jitter) on every failed probe; once it expires, a single
+// half-open probe decides whether polling resumes. Driven by the sampler
+// thread; state() and snapshot() are safe to read from anywhere.
+class CircuitBreaker {
+public:
+    enum class State { Closed, Open, HalfOpen };
+
+    struct Snapshot {
+        State state = State::Closed;
+        uint32_t failures = 0;
+        int64_t retryInMs = 0;   // until the next probe while open
+    };
+
+    CircuitBreaker();
+
+    // Whether a poll may go out now. Moves Open to HalfOpen when the
+    // backoff has run out, letting exactly one probe through.
+    bool allow(std::chrono::steady_clock::time_point now);
+    void recordSuccess();
+    void recordFailure(std::chrono::steady_clock::time_point now);
+    // The allowed poll never reached the server; lets the next one probe
+    void cancelProbe() { probing_ = false; }
+
+    State state() const { return static_cast<State>(state_.load()); }
+    Snapshot snapshot(std::chrono::steady_clock::time_point now) const;
+
+    static const char *stateName(State state);
+
+private:
+    std::atomic<int> state_{static_cast<int>(State::Closed)};
+    std::atomic<uint32_t> failures_{0};
+    std::atomic<int64_t> openUntilNs_{0};
+    bool probing_ = false;
+    std::chrono::milliseconds backoff_;
+    std::minstd_rand rng_;
+};
+
+} // namespace BitrateSwitch
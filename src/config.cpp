@@ -1,6 +1,7 @@
 #include "config.hpp"
 #include <obs-module.h>
 #include <algorithm>
+#include <mutex>
 
 namespace BitrateSwitch {
 
@@ -39,6 +40,7 @@ ServerType getServerTypeFromName(const std::string& name)
 Config::Config()
 {
     setDefaults();
+    publishLocked();
 }
 
 Config::~Config() = default;
@@ -65,6 +67,14 @@ void Config::setDefaults()
     servers.clear();
 }
 
+void Config::publishLocked()
+{
+    auto snap = std::make_shared<ConfigSnapshot>();
+    static_cast<ConfigData &>(*snap) = static_cast<const ConfigData &>(*this);
+    snap->version = ++version_;
+    std::atomic_store(&snapshot_, ConfigPtr(std::move(snap)));
+}
+
 void Config::sortServersByPriority()
 {
     std::sort(servers.begin(), servers.end(),
@@ -107,6 +117,15 @@ obs_data_t *Config::save()
     obs_data_set_bool(data, "switch_to_starting", options.switchToStartingOnStreamStart);
     obs_data_set_bool(data, "switch_from_starting", options.switchFromStartingToLive);
     obs_data_set_int(data, "rist_stale_frame_fix_sec", options.ristStaleFrameFixSec);
+    obs_data_set_int(data, "stale_sample_ms", options.staleSampleMs);
+    obs_data_set_bool(data, "compress_stats", options.compressStats);
+    obs_data_set_bool(data, "revalidate_stats", options.revalidateStats);
+    obs_data_set_bool(data, "adaptive_timeouts", options.adaptiveTimeouts);
+    obs_data_set_int(data, "timeout_min_ms", options.timeoutMinMs);
+    obs_data_set_int(data, "timeout_max_ms", options.timeoutMaxMs);
+    obs_data_set_bool(data, "hedge_primary", options.hedgePrimary);
+    obs_data_set_bool(data, "adaptive_cadence", options.adaptiveCadence);
+    obs_data_set_int(data, "cadence_margin", options.cadenceMarginPercent);
 
     // Stream servers
     obs_data_array_t *serversArray = obs_data_array_create();
@@ -133,6 +152,9 @@ obs_data_t *Config::save()
         // Depends on
         obs_data_set_bool(serverData, "depends_enabled", server.dependsOn.enabled);
         obs_data_set_string(serverData, "depends_server", server.dependsOn.serverName.c_str());
+        obs_data_set_string(serverData, "backup_normal", server.dependsOn.backupScenes.normal.c_str());
+        obs_data_set_string(serverData, "backup_low", server.dependsOn.backupScenes.low.c_str());
+        obs_data_set_string(serverData, "backup_offline", server.dependsOn.backupScenes.offline.c_str());
         
         obs_data_array_push_back(serversArray, serverData);
         obs_data_release(serverData);
@@ -210,6 +232,8 @@ void Config::load(obs_data_t *data)
     if (!data)
         return;
 
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
     // Core settings
     enabled = obs_data_get_bool(data, "enabled");
     onlyWhenStreaming = obs_data_get_bool(data, "only_when_streaming");
@@ -248,6 +272,19 @@ void Config::load(obs_data_t *data)
     options.switchToStartingOnStreamStart = obs_data_get_bool(data, "switch_to_starting");
     options.switchFromStartingToLive = obs_data_get_bool(data, "switch_from_starting");
     options.ristStaleFrameFixSec = static_cast<uint32_t>(obs_data_get_int(data, "rist_stale_frame_fix_sec"));
+    options.staleSampleMs = static_cast<uint32_t>(obs_data_get_int(data, "stale_sample_ms"));
+    if (options.staleSampleMs == 0) options.staleSampleMs = 5000;
+    options.compressStats = obs_data_get_bool(data, "compress_stats");
+    options.revalidateStats = obs_data_get_bool(data, "revalidate_stats");
+    options.adaptiveTimeouts = obs_data_get_bool(data, "adaptive_timeouts");
+    options.timeoutMinMs = static_cast<uint32_t>(obs_data_get_int(data, "timeout_min_ms"));
+    if (options.timeoutMinMs == 0) options.timeoutMinMs = 50;
+    options.timeoutMaxMs = static_cast<uint32_t>(obs_data_get_int(data, "timeout_max_ms"));
+    if (options.timeoutMaxMs == 0) options.timeoutMaxMs = 5000;
+    options.hedgePrimary = obs_data_get_bool(data, "hedge_primary");
+    options.adaptiveCadence = obs_data_get_bool(data, "adaptive_cadence");
+    options.cadenceMarginPercent = static_cast<uint32_t>(obs_data_get_int(data, "cadence_margin"));
+    if (options.cadenceMarginPercent == 0) options.cadenceMarginPercent = 25;
 
     // Stream servers
     servers.clear();
@@ -282,6 +319,12 @@ void Config::load(obs_data_t *data)
             server.dependsOn.enabled = obs_data_get_bool(serverData, "depends_enabled");
             const char *dependsServer = obs_data_get_string(serverData, "depends_server");
             if (dependsServer) server.dependsOn.serverName = dependsServer;
+            const char *bkNormal = obs_data_get_string(serverData, "backup_normal");
+            const char *bkLow = obs_data_get_string(serverData, "backup_low");
+            const char *bkOffline = obs_data_get_string(serverData, "backup_offline");
+            if (bkNormal) server.dependsOn.backupScenes.normal = bkNormal;
+            if (bkLow) server.dependsOn.backupScenes.low = bkLow;
+            if (bkOffline) server.dependsOn.backupScenes.offline = bkOffline;
             
             servers.push_back(server);
             obs_data_release(serverData);
@@ -384,6 +427,8 @@ void Config::load(obs_data_t *data)
         }
         obs_data_array_release(customCmdsArray);
     }
+
+    publishLocked();
 }
 
 } // namespace BitrateSwitch
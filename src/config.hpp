@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <memory>
+#include <atomic>
 #include <shared_mutex>
 
 namespace BitrateSwitch {
@@ -51,7 +53,8 @@ struct OverrideScenes {
     bool enabled = false;
 };
 
-// Server dependency (for backup servers)
+// Server dependency (for backup servers): the server is only used while
+// serverName is offline, and then with backupScenes
 struct DependsOn {
     std::string serverName;
     SwitchingScenes backupScenes;
@@ -81,6 +84,15 @@ struct OptionalOptions {
     bool switchToStartingOnStreamStart = false; // Switch to starting scene on stream start
     bool switchFromStartingToLive = false;     // Auto-switch from starting to live when feed detected
     uint32_t ristStaleFrameFixSec = 0;        // Auto-fix media sources after X seconds offline to clear RIST stale frame (0 = disabled)
+    uint32_t staleSampleMs = 5000;            // Treat a server as offline when its last stats sample is older than this
+    bool compressStats = false;               // Ask stats endpoints for gzip/br/zstd bodies
+    bool revalidateStats = false;             // Send ETag/Last-Modified validators; a 304 reuses the last parse
+    bool adaptiveTimeouts = false;            // Derive each server's request timeout from its own response times
+    uint32_t timeoutMinMs = 50;               // Adaptive timeouts never go below this
+    uint32_t timeoutMaxMs = 5000;             // Upper bound, and the fixed timeout when adaptive is off
+    bool hedgePrimary = false;                // Re-send a slow primary-server request on a second connection
+    bool adaptiveCadence = false;             // Poll faster near the triggers and slower when settled
+    uint32_t cadenceMarginPercent = 25;       // How close to a trigger (or how fast a drop) counts as "near"
 };
 
 // Message templates for chat announcements
@@ -129,6 +141,13 @@ struct ChatConfig {
     // Twitch PubSub raid.* and Kick host/raid events: optional auto-stop when raiding out
     bool autoStopStreamOnRaid = true;
     bool announceRaidStop = true;
+
+    // Where the clients connect. Never saved; tests point them at a
+    // local server.
+    std::string twitchIrcHost = "irc.chat.twitch.tv";
+    int twitchIrcPort = 6667;
+    std::string kickWsUrl = "wss://ws-us2.pusher.com/app/32cbd69e4b950bf97679"
+                            "?protocol=7&client=js&version=7.6.0&flash=false";
     
     // Command prefixes (customizable)
     std::string cmdLive = "!live";
@@ -144,22 +163,9 @@ struct ChatConfig {
     std::string cmdStop = "!stop";
 };
 
-class Config {
-public:
-    Config();
-    ~Config();
-
-    obs_data_t *save();
-    void load(obs_data_t *data);
-    void sortServersByPriority();
-
-    // readers grab shared, writers grab exclusive -- keeps the
-    // switcher thread from seeing half-written strings
-    void lockRead() const  { mutex_.lock_shared(); }
-    void unlockRead() const { mutex_.unlock_shared(); }
-    void lockWrite()       { mutex_.lock(); }
-    void unlockWrite()     { mutex_.unlock(); }
-
+// Every user-editable setting. Config holds the editable copy; the
+// switcher only ever sees immutable ConfigSnapshots of it.
+struct ConfigData {
     // Core settings
     bool enabled = true;
     bool onlyWhenStreaming = false;
@@ -175,10 +181,43 @@ public:
     MessageTemplates messages;
     std::vector<CustomChatCommand> customCommands;
     std::vector<StreamServerConfig> servers;
+};
+
+// A published, never-modified copy of the settings. version increases by
+// one with every publish so decisions can be tied to the config they used.
+struct ConfigSnapshot : ConfigData {
+    uint64_t version = 0;
+};
+
+using ConfigPtr = std::shared_ptr<const ConfigSnapshot>;
+
+class Config : public ConfigData {
+public:
+    Config();
+    ~Config();
+
+    obs_data_t *save();
+    void load(obs_data_t *data);
+    void sortServersByPriority();
+
+    // Editors (settings dialog, websocket SetSettings) modify the fields
+    // between lockWrite() and unlockWrite(); unlocking publishes a new
+    // snapshot. Readers that only need a consistent view should use
+    // snapshot(), which never blocks and is never blocked.
+    void lockRead() const  { mutex_.lock_shared(); }
+    void unlockRead() const { mutex_.unlock_shared(); }
+    void lockWrite()       { mutex_.lock(); }
+    void unlockWrite()     { publishLocked(); mutex_.unlock(); }
+
+    ConfigPtr snapshot() const { return std::atomic_load(&snapshot_); }
 
 private:
     void setDefaults();
+    void publishLocked();
+
     mutable std::shared_mutex mutex_;
+    ConfigPtr snapshot_;
+    uint64_t version_ = 0;
 };
 
 // Helper to get server type name
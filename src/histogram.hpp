@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace BitrateSwitch {
+
+// Millisecond values counted into fixed buckets. Recording and reading
+// are lock-free, so one thread can record while any other reads.
+class Histogram {
+public:
+    // Upper bounds of every bucket but the last, which takes the rest
+    static constexpr std::array<double, 8> kBoundsMs = {1, 2, 5, 10, 20, 50, 100, 250};
+    static constexpr size_t kBuckets = kBoundsMs.size() + 1;
+
+    void record(double ms)
+    {
+        size_t bucket = 0;
+        while (bucket < kBoundsMs.size() && ms > kBoundsMs[bucket])
+            ++bucket;
+        counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::array<uint64_t, kBuckets> counts() const
+    {
+        std::array<uint64_t, kBuckets> result{};
+        for (size_t i = 0; i < kBuckets; i++)
+            result[i] = counts_[i].load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+};
+
+} // namespace BitrateSwitch
@@ -1,130 +1,300 @@
 #include "http-client.hpp"
 #include <obs-module.h>
+#include <atomic>
+#include <cctype>
 
 namespace BitrateSwitch {
 
+namespace {
+
+std::atomic<uint64_t> g_newConnections{0};
+std::atomic<uint64_t> g_reusedConnections{0};
+std::atomic<uint64_t> g_transfers{0};
+std::atomic<uint64_t> g_bytesOnWire{0};
+std::atomic<uint64_t> g_notModified{0};
+
+CURLSH *g_share = nullptr;
+std::mutex g_shareLocks[CURL_LOCK_DATA_LAST];
+
+// Case-insensitive "Name:" match at the start of a header line; returns
+// the trimmed value or an empty view
+std::string_view headerValue(std::string_view line, std::string_view name)
+{
+    if (line.size() <= name.size() || line[name.size()] != ':')
+        return {};
+    for (size_t i = 0; i < name.size(); i++) {
+        if (std::tolower(static_cast<unsigned char>(line[i])) !=
+            std::tolower(static_cast<unsigned char>(name[i])))
+            return {};
+    }
+
+    std::string_view value = line.substr(name.size() + 1);
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        value.remove_prefix(1);
+    while (!value.empty() && (value.back() == '\r' || value.back() == '\n' || value.back() == ' '))
+        value.remove_suffix(1);
+    return value;
+}
+
+void shareLock(CURL *, curl_lock_data data, curl_lock_access, void *)
+{
+    g_shareLocks[data].lock();
+}
+
+void shareUnlock(CURL *, curl_lock_data data, void *)
+{
+    g_shareLocks[data].unlock();
+}
+
+} // anonymous namespace
+
 HttpClient::HttpClient()
 {
 }
 
 HttpClient::~HttpClient()
 {
+    for (auto &entry : handles_)
+        curl_easy_cleanup(entry.second);
 }
 
 size_t HttpClient::writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata)
 {
-    std::string *response = static_cast<std::string *>(userdata);
+    HttpResponse *response = static_cast<HttpResponse *>(userdata);
     size_t totalSize = size * nmemb;
-    response->append(ptr, totalSize);
+
+    if (response->sink) {
+        if (!response->sink(std::string_view(ptr, totalSize))) {
+            // the parser has what it needs; curl aborts with CURLE_WRITE_ERROR
+            response->stoppedEarly = true;
+            return 0;
+        }
+        return totalSize;
+    }
+
+    response->body.append(ptr, totalSize);
     return totalSize;
 }
 
-HttpResponse HttpClient::get(const std::string &url, int timeoutMs)
+size_t HttpClient::headerCallback(char *ptr, size_t size, size_t nmemb, void *userdata)
 {
-    HttpResponse response;
-    
-    CURL *curl = curl_easy_init();
-    if (!curl) {
-        blog(LOG_ERROR, "[BitrateSceneSwitch] Failed to initialize CURL");
-        return response;
-    }
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeoutMs);
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, timeoutMs / 2);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "BitrateSceneSwitch/1.0");
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    HttpResponse *response = static_cast<HttpResponse *>(userdata);
+    size_t totalSize = size * nmemb;
+    std::string_view line(ptr, totalSize);
 
-    CURLcode res = curl_easy_perform(curl);
-    
-    if (res == CURLE_OK) {
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.statusCode);
-        response.success = (response.statusCode >= 200 && response.statusCode < 300);
+    // a new status line (redirect, 100 Continue) starts a fresh header set
+    if (line.compare(0, 5, "HTTP/") == 0) {
+        response->etag.clear();
+        response->lastModified.clear();
+        return totalSize;
     }
 
-    curl_easy_cleanup(curl);
-    return response;
+    std::string_view value = headerValue(line, "etag");
+    if (!value.empty()) {
+        response->etag.assign(value);
+        return totalSize;
+    }
+    value = headerValue(line, "last-modified");
+    if (!value.empty())
+        response->lastModified.assign(value);
+    return totalSize;
 }
 
-HttpResponse HttpClient::get(const std::string &url, const std::string &authHeader, int timeoutMs)
+curl_slist *HttpClient::configureHandle(CURL *curl, const HttpRequest &request,
+                                        HttpResponse *response)
 {
-    HttpResponse response;
-    
-    CURL *curl = curl_easy_init();
-    if (!curl) {
-        blog(LOG_ERROR, "[BitrateSceneSwitch] Failed to initialize CURL");
-        return response;
-    }
-
     struct curl_slist *headers = nullptr;
-    if (!authHeader.empty()) {
-        std::string header = "Authorization: " + authHeader;
+    if (!request.authHeader.empty()) {
+        std::string header = "Authorization: " + request.authHeader;
         headers = curl_slist_append(headers, header.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     }
 
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    if (request.post) {
+        std::string ctHeader = "Content-Type: " + request.contentType;
+        headers = curl_slist_append(headers, ctHeader.c_str());
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        // multi transfers outlive the request they were built from, so curl
+        // keeps its own copy of the body; the size has to be set first
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(request.body.size()));
+        curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, request.body.c_str());
+    }
+
+    if (!request.ifNoneMatch.empty())
+        headers = curl_slist_append(headers, ("If-None-Match: " + request.ifNoneMatch).c_str());
+    if (!request.ifModifiedSince.empty())
+        headers = curl_slist_append(headers, ("If-Modified-Since: " + request.ifModifiedSince).c_str());
+
+    if (headers)
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    // "" advertises every encoding this libcurl can decode
+    if (request.compressed)
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+
+    curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeoutMs);
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, timeoutMs / 2);
+    response->sink = request.onData;
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, response);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(request.timeoutMs));
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(request.timeoutMs / 2));
+    if (request.freshConnection)
+        curl_easy_setopt(curl, CURLOPT_FRESH_CONNECT, 1L);
     curl_easy_setopt(curl, CURLOPT_USERAGENT, "BitrateSceneSwitch/1.0");
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    // multi transfers run on the switcher thread; never raise SIGALRM
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    // stats endpoints are polled every second; keep the socket warm
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 15L);
+    if (g_share)
+        curl_easy_setopt(curl, CURLOPT_SHARE, g_share);
 
-    CURLcode res = curl_easy_perform(curl);
-    
-    if (res == CURLE_OK) {
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.statusCode);
-        response.success = (response.statusCode >= 200 && response.statusCode < 300);
+    return headers;
+}
+
+void HttpClient::finishHandle(CURL *curl, CURLcode result, HttpResponse *response)
+{
+    curl_off_t totalUs = 0;
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &totalUs);
+    response->elapsedMs = static_cast<double>(totalUs) / 1000.0;
+    response->timedOut = result == CURLE_OPERATION_TIMEDOUT;
+
+    // a sink stopping the transfer on purpose is not a failure
+    if (result == CURLE_OK || (result == CURLE_WRITE_ERROR && response->stoppedEarly)) {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response->statusCode);
+        response->success = (response->statusCode >= 200 && response->statusCode < 300);
+        response->notModified = response->statusCode == 304;
+        if (response->notModified)
+            g_notModified++;
+
+        // download size counts the body as received, before decoding
+        long headerBytes = 0;
+        curl_off_t bodyBytes = 0;
+        curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &headerBytes);
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &bodyBytes);
+        response->bytesOnWire = static_cast<uint64_t>(headerBytes) + static_cast<uint64_t>(bodyBytes);
+        g_bytesOnWire += response->bytesOnWire;
+        g_transfers++;
+
+        long connects = 0;
+        curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+        if (connects > 0)
+            g_newConnections += static_cast<uint64_t>(connects);
+        else
+            g_reusedConnections++;
     }
+}
 
-    if (headers) curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-    return response;
+std::string HttpClient::hostKey(const std::string &url)
+{
+    size_t start = url.find("://");
+    start = (start == std::string::npos) ? 0 : start + 3;
+    size_t end = url.find_first_of("/?#", start);
+    return url.substr(0, end);
 }
 
-HttpResponse HttpClient::post(const std::string &url, const std::string &body,
-                              const std::string &contentType, int timeoutMs)
+ConnectionStats HttpClient::connectionStats()
 {
-    HttpResponse response;
-    
-    CURL *curl = curl_easy_init();
-    if (!curl) {
-        blog(LOG_ERROR, "[BitrateSceneSwitch] Failed to initialize CURL");
-        return response;
+    ConnectionStats stats;
+    stats.newConnections = g_newConnections.load();
+    stats.reusedConnections = g_reusedConnections.load();
+    stats.transfers = g_transfers.load();
+    stats.bytesOnWire = g_bytesOnWire.load();
+    stats.notModified = g_notModified.load();
+    return stats;
+}
+
+void HttpClient::initShared()
+{
+    if (g_share)
+        return;
+
+    g_share = curl_share_init();
+    if (!g_share) {
+        blog(LOG_WARNING, "[BitrateSceneSwitch] Failed to create CURL share, caches stay per handle");
+        return;
     }
 
-    struct curl_slist *headers = nullptr;
-    std::string ctHeader = "Content-Type: " + contentType;
-    headers = curl_slist_append(headers, ctHeader.c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeoutMs);
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, timeoutMs / 2);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "BitrateSceneSwitch/1.0");
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_share_setopt(g_share, CURLSHOPT_LOCKFUNC, shareLock);
+    curl_share_setopt(g_share, CURLSHOPT_UNLOCKFUNC, shareUnlock);
+    curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+}
 
-    CURLcode res = curl_easy_perform(curl);
-    
-    if (res == CURLE_OK) {
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.statusCode);
-        response.success = (response.statusCode >= 200 && response.statusCode < 300);
+void HttpClient::cleanupShared()
+{
+    if (!g_share)
+        return;
+
+    CURLSHcode rc = curl_share_cleanup(g_share);
+    if (rc != CURLSHE_OK) {
+        // a handle still references it; leaking beats a use-after-free
+        blog(LOG_WARNING, "[BitrateSceneSwitch] CURL share still in use at unload: %s",
+             curl_share_strerror(rc));
+    }
+    g_share = nullptr;
+}
+
+HttpResponse HttpClient::perform(const HttpRequest &request)
+{
+    HttpResponse response;
+    std::lock_guard<std::mutex> lock(handlesMutex_);
+
+    CURL *&curl = handles_[hostKey(request.url)];
+    if (curl) {
+        // keeps live connections, DNS and TLS session caches
+        curl_easy_reset(curl);
+    } else {
+        curl = curl_easy_init();
+        if (!curl) {
+            blog(LOG_ERROR, "[BitrateSceneSwitch] Failed to initialize CURL");
+            handles_.erase(hostKey(request.url));
+            return response;
+        }
     }
 
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+    struct curl_slist *headers = configureHandle(curl, request, &response);
+    CURLcode res = curl_easy_perform(curl);
+    finishHandle(curl, res, &response);
+
+    // drop the options that point into this call's stack frame
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+    if (headers) curl_slist_free_all(headers);
     return response;
 }
 
+HttpResponse HttpClient::get(const std::string &url, int timeoutMs)
+{
+    HttpRequest request;
+    request.url = url;
+    request.timeoutMs = timeoutMs;
+    return perform(request);
+}
+
+HttpResponse HttpClient::get(const std::string &url, const std::string &authHeader, int timeoutMs)
+{
+    HttpRequest request;
+    request.url = url;
+    request.authHeader = authHeader;
+    request.timeoutMs = timeoutMs;
+    return perform(request);
+}
+
+HttpResponse HttpClient::post(const std::string &url, const std::string &body,
+                              const std::string &contentType, int timeoutMs)
+{
+    HttpRequest request;
+    request.url = url;
+    request.body = body;
+    request.contentType = contentType;
+    request.post = true;
+    request.timeoutMs = timeoutMs;
+    return perform(request);
+}
+
 } // namespace BitrateSwitch
@@ -1,15 +1,84 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
 #include <curl/curl.h>
 
 namespace BitrateSwitch {
 
+// Receives body chunks as they arrive for a streaming request. Returning
+// false tells curl to stop the transfer; the rest is never downloaded.
+using HttpDataSink = std::function<bool(std::string_view chunk)>;
+
 struct HttpResponse {
     long statusCode = 0;
     std::string body;
     bool success = false;
+
+    // Set instead of body when one transfer answered several identical
+    // requests; every copy of the response points at the same text
+    std::shared_ptr<const std::string> sharedBody;
+
+    // The body, wherever it lives. Parsers should read through this.
+    std::string_view text() const { return sharedBody ? std::string_view(*sharedBody) : std::string_view(body); }
+
+    // Streaming requests leave body empty; stoppedEarly is set when the
+    // sink ended the transfer before the whole body arrived
+    HttpDataSink sink;
+    bool stoppedEarly = false;
+
+    // Validators for the next conditional request; notModified is a 304,
+    // which carries no body
+    std::string etag;
+    std::string lastModified;
+    bool notModified = false;
+
+    // Headers plus body as received, i.e. before decompression
+    uint64_t bytesOnWire = 0;
+
+    // Wall time of the transfer, and whether it ran out of time
+    double elapsedMs = 0.0;
+    bool timedOut = false;
+};
+
+// Everything needed to issue one stats request. Servers describe their
+// requests with this so the poll engine can run them concurrently.
+struct HttpRequest {
+    std::string url;
+    std::string authHeader;
+    std::string body;
+    std::string contentType = "application/json";
+    bool post = false;
+    int timeoutMs = 5000;
+
+    // Optional: parse the body incrementally instead of buffering it
+    HttpDataSink onData;
+
+    // Accept any encoding curl was built with (gzip, br, zstd)
+    bool compressed = false;
+    // Conditional request; empty means unconditional
+    std::string ifNoneMatch;
+    std::string ifModifiedSince;
+
+    // Send a second copy on its own connection if this one hasn't
+    // finished after hedgeAfterMs (0 = never); the first answer wins
+    int hedgeAfterMs = 0;
+    bool freshConnection = false;
+};
+
+// Process-wide connection reuse counters, fed from CURLINFO_NUM_CONNECTS
+// after every transfer. A transfer that opened no connection reused one.
+struct ConnectionStats {
+    uint64_t newConnections = 0;
+    uint64_t reusedConnections = 0;
+    uint64_t transfers = 0;
+    uint64_t bytesOnWire = 0;
+    uint64_t notModified = 0;
 };
 
 class HttpClient {
@@ -17,13 +86,42 @@ public:
     HttpClient();
     ~HttpClient();
 
+    HttpClient(const HttpClient &) = delete;
+    HttpClient &operator=(const HttpClient &) = delete;
+
+    HttpResponse perform(const HttpRequest &request);
+
     HttpResponse get(const std::string &url, int timeoutMs = 5000);
     HttpResponse get(const std::string &url, const std::string &authHeader, int timeoutMs = 5000);
     HttpResponse post(const std::string &url, const std::string &body,
                       const std::string &contentType = "application/json", int timeoutMs = 5000);
 
+    // Shared by perform() and PollEngine so both paths set identical options.
+    // The returned header list must outlive the transfer; free it with
+    // curl_slist_free_all().
+    static curl_slist *configureHandle(CURL *curl, const HttpRequest &request,
+                                       HttpResponse *response);
+    static void finishHandle(CURL *curl, CURLcode result, HttpResponse *response);
+
+    // "scheme://host:port" part of a URL, used to key pooled handles
+    static std::string hostKey(const std::string &url);
+    static ConnectionStats connectionStats();
+
+    // Process-wide share of DNS, TLS sessions and connections used by every
+    // handle, so servers on the same host (and a fresh set of servers after
+    // reloadServers) skip the handshakes. Call after curl_global_init and
+    // before curl_global_cleanup, once every handle has been released.
+    static void initShared();
+    static void cleanupShared();
+
 private:
     static size_t writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata);
+    static size_t headerCallback(char *ptr, size_t size, size_t nmemb, void *userdata);
+
+    // One easy handle per host, kept alive between polls so the TCP
+    // connection and TLS session are reused instead of renegotiated
+    std::mutex handlesMutex_;
+    std::map<std::string, CURL *> handles_;
 };
 
 } // namespace BitrateSwitch
@@ -0,0 +1,233 @@
+#include "json-scan.hpp"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kMaxDepth = 64;
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// pos is on the opening quote; returns the index just past the closing one
+size_t skipString(std::string_view s, size_t pos)
+{
+    for (++pos; pos < s.size(); ++pos) {
+        if (s[pos] == '\\') ++pos;
+        else if (s[pos] == '"') return pos + 1;
+    }
+    return s.size();
+}
+
+size_t skipSpace(std::string_view s, size_t pos)
+{
+    while (pos < s.size() && isSpace(s[pos])) ++pos;
+    return pos;
+}
+
+// A bare value (number, true/false/null) runs up to the next delimiter
+std::string_view scalarAt(std::string_view s, size_t pos)
+{
+    size_t end = pos;
+    while (end < s.size() && s[end] != ',' && s[end] != '}' && s[end] != ']' &&
+           s[end] != '\n' && s[end] != '\r')
+        ++end;
+    while (end > pos && (s[end - 1] == ' ' || s[end - 1] == '\t')) --end;
+    return s.substr(pos, end - pos);
+}
+
+void finish(BitrateSwitch::JsonQuery &q, std::string_view value, size_t &remaining)
+{
+    q.value = value;
+    q.found = true;
+    q.done = true;
+    --remaining;
+}
+
+// Copies a number into a small stack buffer so strtoll/strtod see a
+// terminated string
+bool toBuffer(std::string_view value, char (&buf)[64])
+{
+    if (value.empty() || value.size() >= sizeof(buf)) return false;
+    std::memcpy(buf, value.data(), value.size());
+    buf[value.size()] = '\0';
+    return true;
+}
+
+} // anonymous namespace
+
+namespace BitrateSwitch {
+
+JsonQuery::JsonQuery(std::initializer_list<std::string_view> path)
+{
+    for (std::string_view key : path) {
+        if (length == kMaxJsonPath) break;
+        keys[length++] = key;
+    }
+}
+
+size_t jsonScan(std::string_view json, JsonQuery *queries, size_t count)
+{
+    size_t remaining = 0;
+    for (size_t i = 0; i < count; ++i) {
+        JsonQuery &q = queries[i];
+        q.value = {};
+        q.found = false;
+        q.progress = 0;
+        q.captureStart = std::string_view::npos;
+        q.done = q.length == 0;
+        if (!q.done) ++remaining;
+    }
+
+    bool isObject[kMaxDepth] = {};
+    size_t depth = 0;
+    bool expectKey = true;  // json may start part-way through an object
+    size_t pos = 0;
+
+    while (pos < json.size() && remaining > 0) {
+        char c = json[pos];
+
+        if (c == '"') {
+            size_t end = skipString(json, pos);
+            if (!expectKey) {
+                pos = end;
+                continue;
+            }
+
+            std::string_view key = json.substr(pos + 1, end - pos - 2);
+            expectKey = false;
+
+            size_t valuePos = skipSpace(json, end);
+            if (valuePos < json.size() && json[valuePos] == ':')
+                valuePos = skipSpace(json, valuePos + 1);
+            if (valuePos >= json.size()) break;
+
+            char v = json[valuePos];
+            bool container = v == '{' || v == '[';
+
+            for (size_t i = 0; i < count; ++i) {
+                JsonQuery &q = queries[i];
+                if (q.done || q.captureStart != std::string_view::npos) continue;
+                if (q.keys[q.progress] != key) continue;
+
+                if (q.progress + 1 < q.length) {
+                    // Intermediate keys only make sense on a container
+                    if (container) q.matchDepth[q.progress++] = depth + 1;
+                } else if (container) {
+                    q.captureStart = valuePos;
+                    q.captureDepth = depth + 1;
+                } else if (v == '"') {
+                    size_t valueEnd = skipString(json, valuePos);
+                    finish(q, json.substr(valuePos + 1, valueEnd - valuePos - 2), remaining);
+                } else {
+                    finish(q, scalarAt(json, valuePos), remaining);
+                }
+            }
+
+            // Resume on the value itself so containers are tracked
+            pos = valuePos;
+            continue;
+        }
+
+        if (c == '{' || c == '[') {
+            if (depth < kMaxDepth) isObject[depth] = c == '{';
+            ++depth;
+            expectKey = c == '{';
+        } else if (c == '}' || c == ']') {
+            if (depth == 0) break;
+
+            for (size_t i = 0; i < count; ++i) {
+                JsonQuery &q = queries[i];
+                if (q.done) continue;
+                if (q.captureStart != std::string_view::npos && q.captureDepth == depth) {
+                    finish(q, json.substr(q.captureStart, pos + 1 - q.captureStart), remaining);
+                } else if (q.captureStart == std::string_view::npos && q.progress > 0 &&
+                           q.matchDepth[q.progress - 1] == depth) {
+                    // Left the matched container without finding the rest
+                    q.done = true;
+                    --remaining;
+                }
+            }
+
+            --depth;
+            expectKey = false;
+        } else if (c == ',') {
+            expectKey = depth == 0 || depth > kMaxDepth || isObject[depth - 1];
+        }
+        ++pos;
+    }
+
+    size_t found = 0;
+    for (size_t i = 0; i < count; ++i)
+        if (queries[i].found) ++found;
+    return found;
+}
+
+std::string_view jsonFind(std::string_view json, std::initializer_list<std::string_view> path)
+{
+    JsonQuery query(path);
+    jsonScan(json, &query, 1);
+    return query.value;
+}
+
+size_t jsonElementEnd(std::string_view json, size_t pos)
+{
+    if (pos >= json.size()) return json.size();
+
+    char c = json[pos];
+    if (c == '"') return skipString(json, pos);
+    if (c != '{' && c != '[') {
+        std::string_view scalar = scalarAt(json, pos);
+        return pos + scalar.size();
+    }
+
+    size_t depth = 0;
+    while (pos < json.size()) {
+        c = json[pos];
+        if (c == '"') {
+            pos = skipString(json, pos);
+            continue;
+        }
+        if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) return pos + 1;
+        }
+        ++pos;
+    }
+    return json.size();
+}
+
+bool jsonToInt(std::string_view value, int64_t &out)
+{
+    char buf[64];
+    if (!toBuffer(value, buf)) return false;
+    char *end = nullptr;
+    long long parsed = std::strtoll(buf, &end, 10);
+    if (end == buf) return false;
+    out = parsed;
+    return true;
+}
+
+bool jsonToInt(std::string_view value, int &out)
+{
+    int64_t parsed = 0;
+    if (!jsonToInt(value, parsed)) return false;
+    out = static_cast<int>(parsed);
+    return true;
+}
+
+bool jsonToDouble(std::string_view value, double &out)
+{
+    char buf[64];
+    if (!toBuffer(value, buf)) return false;
+    char *end = nullptr;
+    double parsed = std::strtod(buf, &end);
+    if (end == buf) return false;
+    out = parsed;
+    return true;
+}
+
+} // namespace BitrateSwitch
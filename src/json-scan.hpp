@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+
+namespace BitrateSwitch {
+
+constexpr size_t kMaxJsonPath = 4;
+
+// One key path to resolve, e.g. {"publishers", key, "bitrate"}. Each key is
+// matched anywhere below the previous one and the first match wins, which
+// is what the stats parsers have always relied on. The result points into
+// the scanned buffer: strings come back without quotes (escapes are left
+// as-is), objects and arrays with their brackets.
+struct JsonQuery {
+    JsonQuery(std::initializer_list<std::string_view> keys);
+
+    std::string_view keys[kMaxJsonPath];
+    size_t length = 0;
+
+    std::string_view value;
+    bool found = false;
+
+    // Scan state
+    size_t progress = 0;
+    size_t matchDepth[kMaxJsonPath] = {};
+    size_t captureStart = 0;
+    size_t captureDepth = 0;
+    bool done = false;
+};
+
+// Resolves every query in a single pass over json and stops as soon as all
+// of them are answered. Never allocates. Returns how many were found.
+// json may also start at a key part-way through an object, in which case
+// the scan ends where that object does.
+size_t jsonScan(std::string_view json, JsonQuery *queries, size_t count);
+
+template <size_t N>
+size_t jsonScan(std::string_view json, JsonQuery (&queries)[N])
+{
+    return jsonScan(json, queries, N);
+}
+
+// Single-path convenience wrapper around jsonScan
+std::string_view jsonFind(std::string_view json, std::initializer_list<std::string_view> path);
+
+// Number conversion without exceptions; out is left untouched on failure.
+// Trailing garbage is ignored the same way std::stoll/std::stod do.
+bool jsonToInt(std::string_view value, int64_t &out);
+bool jsonToInt(std::string_view value, int &out);
+bool jsonToDouble(std::string_view value, double &out);
+
+// Index just past the JSON value that starts at pos
+size_t jsonElementEnd(std::string_view json, size_t pos);
+
+// Splits a JSON array ("[...]") into its top-level elements. fn receives
+// each element and returns false to stop early.
+template <typename Fn>
+void jsonForEach(std::string_view array, Fn fn)
+{
+    size_t pos = array.find('[');
+    if (pos == std::string_view::npos) return;
+    ++pos;
+
+    while (pos < array.size()) {
+        pos = array.find_first_not_of(" \t\r\n,", pos);
+        if (pos == std::string_view::npos || array[pos] == ']') return;
+
+        size_t end = jsonElementEnd(array, pos);
+        if (!fn(array.substr(pos, end - pos))) return;
+        pos = end;
+    }
+}
+
+} // namespace BitrateSwitch
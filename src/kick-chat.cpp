@@ -16,9 +16,11 @@
 
 namespace BitrateSwitch {
 
-static const char *kKickWsUrl =
-	"wss://ws-us2.pusher.com/app/32cbd69e4b950bf97679"
-	"?protocol=7&client=js&version=7.6.0&flash=false";
+// pusher servers ping ~every 30s; declare dead at 90s of silence
+static constexpr int kLivenessSec = 90;
+static constexpr int kClientPingSec = 60;
+// how often the above are checked
+static constexpr int kCheckSec = 5;
 
 struct KickUiCmd {
 	KickChatClient::CommandCallback cb;
@@ -205,12 +207,13 @@ void KickChatClient::dispatchText(const std::string &utf8)
 		handleHostRaidJson(data);
 }
 
-void KickChatClient::workerMain()
+bool KickChatClient::openSession()
 {
-	if (!ws_.connect(kKickWsUrl)) {
-		blog(LOG_WARNING,
-		     "[BitrateSceneSwitch] Kick: failed to connect");
-		return;
+	if (!ws_.connect(config_.kickWsUrl)) {
+		if (running_)
+			blog(LOG_WARNING,
+			     "[BitrateSceneSwitch] Kick: failed to connect");
+		return false;
 	}
 
 	std::string subTpl =
@@ -227,50 +230,76 @@ void KickChatClient::workerMain()
 			 .c_str());
 	ws_.send(buf);
 
+	lastPing_ = std::chrono::steady_clock::now();
+	lastTraffic_ = lastPing_;
 	connected_ = true;
 	blog(LOG_INFO, "[BitrateSceneSwitch] Kick: subscribed");
+	return true;
+}
 
-	auto lastPing = std::chrono::steady_clock::now();
-	auto lastTraffic = lastPing;
-	// pusher servers ping ~every 30s; declare dead at 90s of silence
-	constexpr int kLivenessSec = 90;
-	constexpr int kClientPingSec = 60;
-
-	while (running_) {
+bool KickChatClient::onReadable()
+{
+	for (;;) {
 		std::string msg;
-		auto result = ws_.recv(msg);
-
+		auto result = ws_.tryRecv(msg);
 		if (result == WsClient::RecvResult::Message) {
-			lastTraffic = std::chrono::steady_clock::now();
+			lastTraffic_ = std::chrono::steady_clock::now();
 			dispatchText(msg);
 		} else if (result == WsClient::RecvResult::Timeout) {
-			auto now = std::chrono::steady_clock::now();
-			auto silent = std::chrono::duration_cast<
-					     std::chrono::seconds>(
-					     now - lastTraffic)
-					     .count();
-			if (silent >= kLivenessSec) {
-				blog(LOG_WARNING,
-				     "[BitrateSceneSwitch] Kick: no traffic for %llds, declaring dead",
-				     (long long)silent);
-				break;
-			}
-			auto sincePing = std::chrono::duration_cast<
-						std::chrono::seconds>(
-						now - lastPing)
-						.count();
-			if (sincePing >= kClientPingSec) {
-				ws_.send("{\"event\":\"pusher:ping\","
-					 "\"data\":{}}");
-				lastPing = now;
-			}
+			return true;
 		} else {
-			break;
+			connected_ = false;
+			return false;
 		}
 	}
+}
 
+bool KickChatClient::onTimer()
+{
+	auto now = std::chrono::steady_clock::now();
+	auto silent = std::chrono::duration_cast<std::chrono::seconds>(
+			      now - lastTraffic_)
+			      .count();
+	if (silent >= kLivenessSec) {
+		blog(LOG_WARNING,
+		     "[BitrateSceneSwitch] Kick: no traffic for %llds, declaring dead",
+		     (long long)silent);
+		connected_ = false;
+		return false;
+	}
+	auto sincePing = std::chrono::duration_cast<std::chrono::seconds>(
+				 now - lastPing_)
+				 .count();
+	if (sincePing >= kClientPingSec) {
+		ws_.send("{\"event\":\"pusher:ping\","
+			 "\"data\":{}}");
+		lastPing_ = now;
+	}
+	return true;
+}
+
+void KickChatClient::workerMain()
+{
+	bool opened = openSession();
+	connecting_ = false;
+	if (!opened)
+		return;
+
+#ifdef _WIN32
+	while (running_ && onReadable() && onTimer()) {
+	}
 	ws_.disconnect();
 	connected_ = false;
+#else
+	// hand the session over; the socket is left open until disconnect()
+	// so its number can't be reused while the reactor still watches it
+	reactorId_ = reactor_->add(
+		ws_.activeSocket(), [this] { return onReadable(); },
+		[this] { return onTimer(); },
+		std::chrono::seconds(kCheckSec));
+	if (reactorId_ == 0)
+		connected_ = false;
+#endif
 }
 
 bool KickChatClient::connect()
@@ -284,6 +313,8 @@ bool KickChatClient::connect()
 	}
 
 	running_ = true;
+	connecting_ = true;
+	ws_.clearInterrupt();
 	worker_ = std::thread([this]() { workerMain(); });
 	return true;
 }
@@ -291,11 +322,18 @@ bool KickChatClient::connect()
 void KickChatClient::disconnect()
 {
 	running_ = false;
-	// worker exits within ~1s via the recv poll timeout; join first so
+	// wake the worker out of connect/recv; join before disconnecting so
 	// libcurl's easy handle isn't freed out from under curl_ws_recv
+	ws_.interrupt();
 	if (worker_.joinable())
 		worker_.join();
+#ifndef _WIN32
+	reactor_->remove(reactorId_);
+	reactorId_ = 0;
+#endif
 	ws_.disconnect();
+	connected_ = false;
+	connecting_ = false;
 }
 
 bool KickChatClient::isConnected() const
@@ -303,6 +341,11 @@ bool KickChatClient::isConnected() const
 	return connected_;
 }
 
+bool KickChatClient::isConnecting() const
+{
+	return connecting_;
+}
+
 void KickChatClient::sendMessage(const std::string &) {}
 
 } // namespace BitrateSwitch
@@ -2,9 +2,12 @@
 
 #include "chat-client.hpp"
 #include "config.hpp"
+#include "net-reactor.hpp"
 #include "ws-client.hpp"
 #include <atomic>
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <thread>
 
 namespace BitrateSwitch {
@@ -25,10 +28,17 @@ public:
 	bool connect();
 	void disconnect();
 	bool isConnected() const;
+	bool isConnecting() const;
 	void sendMessage(const std::string &);
 
 private:
+	// The worker only connects and subscribes; the session then runs on
+	// the network reactor (or stays on the worker on Windows). The
+	// handlers return false once the connection is gone.
 	void workerMain();
+	bool openSession();
+	bool onReadable();
+	bool onTimer();
 	void dispatchText(const std::string &utf8);
 	static bool parsePusherEvent(const std::string &utf8,
 				     std::string *eventName,
@@ -43,7 +53,15 @@ private:
 	WsClient ws_;
 	std::atomic<bool> running_{false};
 	std::atomic<bool> connected_{false};
+	std::atomic<bool> connecting_{false};
 	std::thread worker_;
+#ifndef _WIN32
+	const std::shared_ptr<NetReactor> reactor_ = NetReactor::shared();
+	NetReactor::Id reactorId_ = 0;
+#endif
+
+	std::chrono::steady_clock::time_point lastPing_;
+	std::chrono::steady_clock::time_point lastTraffic_;
 };
 
 } // namespace BitrateSwitch
@@ -0,0 +1,55 @@
+#include "latency-tracker.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace BitrateSwitch {
+
+namespace {
+
+constexpr double kTimeoutMultiplier = 4.0;
+
+} // anonymous namespace
+
+void LatencyTracker::record(double ms)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    samples_[next_] = ms;
+    next_ = (next_ + 1) % kWindow;
+    count_ = (std::min)(count_ + 1, kWindow);
+}
+
+size_t LatencyTracker::count() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+double LatencyTracker::percentile(double p) const
+{
+    std::array<double, kWindow> sorted;
+    size_t n;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        n = count_;
+        std::copy(samples_.begin(), samples_.begin() + n, sorted.begin());
+    }
+    if (n == 0)
+        return 0.0;
+
+    // nearest rank, so p99 of a small window is its maximum
+    size_t rank = static_cast<size_t>(std::ceil(std::clamp(p, 0.0, 1.0) * n));
+    size_t index = rank > 0 ? rank - 1 : 0;
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.begin() + n);
+    return sorted[index];
+}
+
+int LatencyTracker::timeoutMs(int minMs, int maxMs) const
+{
+    maxMs = (std::max)(minMs, maxMs);
+    if (count() < kMinSamples)
+        return maxMs;
+    double timeout = std::ceil(kTimeoutMultiplier * percentile(0.99));
+    return static_cast<int>(std::clamp(timeout, static_cast<double>(minMs), static_cast<double>(maxMs)));
+}
+
+} // namespace BitrateSwitch
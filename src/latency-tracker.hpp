@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+
+namespace BitrateSwitch {
+
+// Response times of one server over its last kWindow polls. Percentiles
+// come from that window, so the estimate follows the server as it speeds
+// up or slows down instead of averaging over the whole session. Written
+// by the sampler thread, readable from any thread.
+class LatencyTracker {
+public:
+    static constexpr size_t kWindow = 64;
+    // below this the tail estimate is mostly noise
+    static constexpr size_t kMinSamples = 8;
+
+    void record(double ms);
+    size_t count() const;
+
+    // p in [0, 1]; 0 when nothing has been recorded yet
+    double percentile(double p) const;
+
+    // Total timeout for the next request: multiplier x p99, clamped to
+    // [minMs, maxMs]. Stays at maxMs until enough samples are in.
+    int timeoutMs(int minMs, int maxMs) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::array<double, kWindow> samples_{};
+    size_t next_ = 0;
+    size_t count_ = 0;
+};
+
+} // namespace BitrateSwitch
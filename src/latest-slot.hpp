@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace BitrateSwitch {
+
+// Holds the most recent value published by one writer. Readers get an
+// immutable snapshot and never wait for the writer to finish with the
+// network; replacing the value is a single pointer swap. (C++17 has no
+// std::atomic<std::shared_ptr>, hence the atomic_* free functions.)
+template <typename T>
+class LatestSlot {
+public:
+    void publish(T value)
+    {
+        std::atomic_store(&value_, std::shared_ptr<const T>(std::make_shared<T>(std::move(value))));
+    }
+
+    std::shared_ptr<const T> load() const { return std::atomic_load(&value_); }
+
+    void clear() { std::atomic_store(&value_, std::shared_ptr<const T>()); }
+
+private:
+    std::shared_ptr<const T> value_;
+};
+
+} // namespace BitrateSwitch
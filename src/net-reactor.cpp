@@ -0,0 +1,311 @@
+#include "net-reactor.hpp"
+
+#ifndef _WIN32
+
+#include <obs-module.h>
+#include <algorithm>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+namespace BitrateSwitch {
+
+namespace {
+
+// ready sockets handled per wait; more are picked up on the next one
+constexpr int kMaxEvents = 16;
+
+// wake entry's id in the epoll set; registrations start at 1
+constexpr NetReactor::Id kWakeId = 0;
+
+std::mutex g_sharedMutex;
+std::weak_ptr<NetReactor> g_shared;
+
+} // anonymous namespace
+
+std::shared_ptr<NetReactor> NetReactor::shared()
+{
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    std::shared_ptr<NetReactor> reactor = g_shared.lock();
+    if (!reactor) {
+        reactor = std::make_shared<NetReactor>();
+        g_shared = reactor;
+    }
+    return reactor;
+}
+
+NetReactor::NetReactor()
+{
+#ifdef __linux__
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFds_[0] = wakeFds_[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ >= 0 && wakeFds_[0] >= 0) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = kWakeId;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFds_[0], &ev);
+    }
+#else
+    if (pipe(wakeFds_) == 0) {
+        for (int fd : wakeFds_) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+    } else {
+        wakeFds_[0] = wakeFds_[1] = -1;
+    }
+#endif
+    if (wakeFds_[0] < 0)
+        blog(LOG_ERROR, "[BitrateSceneSwitch] Network reactor: no wake descriptor");
+
+    thread_ = std::thread(&NetReactor::reactorThread, this);
+}
+
+NetReactor::~NetReactor()
+{
+    stopping_ = true;
+    wake();
+    if (thread_.joinable())
+        thread_.join();
+
+    if (epollFd_ >= 0)
+        close(epollFd_);
+    if (wakeFds_[0] >= 0)
+        close(wakeFds_[0]);
+    if (wakeFds_[1] >= 0 && wakeFds_[1] != wakeFds_[0])
+        close(wakeFds_[1]);
+}
+
+NetReactor::Id NetReactor::add(int fd, Handler onReadable, Handler onTimer,
+                               std::chrono::milliseconds timerPeriod, Handler onWritable)
+{
+    if (fd < 0)
+        return 0;
+
+    auto reg = std::make_shared<Registration>();
+    reg->fd = fd;
+    reg->onReadable = std::move(onReadable);
+    reg->onTimer = std::move(onTimer);
+    reg->onWritable = std::move(onWritable);
+    reg->period = timerPeriod;
+    reg->nextTimer = std::chrono::steady_clock::now();
+
+    Id id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = nextId_++;
+#ifdef __linux__
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = id;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            blog(LOG_WARNING, "[BitrateSceneSwitch] Network reactor: can't watch socket %d", fd);
+            return 0;
+        }
+#endif
+        registrations_[id] = std::move(reg);
+    }
+    wake();
+    return id;
+}
+
+void NetReactor::remove(Id id)
+{
+    if (id == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (std::this_thread::get_id() != thread_.get_id())
+        handlerDone_.wait(lock, [&] { return inHandler_ != id; });
+    eraseLocked(id);
+}
+
+void NetReactor::watchWritable(Id id, bool on)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = registrations_.find(id);
+        if (it == registrations_.end() || it->second->wantWritable == on)
+            return;
+        it->second->wantWritable = on;
+#ifdef __linux__
+        epoll_event ev = {};
+        ev.events = on ? static_cast<uint32_t>(EPOLLIN | EPOLLOUT) : static_cast<uint32_t>(EPOLLIN);
+        ev.data.u64 = id;
+        epoll_ctl(epollFd_, EPOLL_CTL_MOD, it->second->fd, &ev);
+        return;
+#endif
+    }
+    // poll() picks up the new interest on its next round
+    wake();
+}
+
+void NetReactor::fireTimer(Id id)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = registrations_.find(id);
+        if (it == registrations_.end())
+            return;
+        it->second->nextTimer = std::chrono::steady_clock::now();
+    }
+    wake();
+}
+
+void NetReactor::eraseLocked(Id id)
+{
+    auto it = registrations_.find(id);
+    if (it == registrations_.end())
+        return;
+#ifdef __linux__
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, it->second->fd, nullptr);
+#endif
+    registrations_.erase(it);
+}
+
+void NetReactor::wake()
+{
+    if (wakeFds_[1] < 0)
+        return;
+#ifdef __linux__
+    uint64_t one = 1;
+    ssize_t n = write(wakeFds_[1], &one, sizeof(one));
+#else
+    char one = 1;
+    ssize_t n = write(wakeFds_[1], &one, sizeof(one));
+#endif
+    (void)n; // already readable when the counter or pipe is full
+}
+
+void NetReactor::drainWake()
+{
+    char buf[64];
+    while (read(wakeFds_[0], buf, sizeof(buf)) > 0) {
+    }
+}
+
+int NetReactor::waitMsLocked(std::chrono::steady_clock::time_point now) const
+{
+    int waitMs = -1;
+    for (const auto &entry : registrations_) {
+        auto until = std::chrono::ceil<std::chrono::milliseconds>(entry.second->nextTimer - now);
+        int ms = static_cast<int>((std::max)(until.count(), static_cast<decltype(until.count())>(0)));
+        waitMs = waitMs < 0 ? ms : (std::min)(waitMs, ms);
+    }
+    // no wake descriptor: fall back to checking back every second
+    if (wakeFds_[0] < 0 && (waitMs < 0 || waitMs > 1000))
+        waitMs = 1000;
+    return waitMs;
+}
+
+void NetReactor::dispatch(Id id, Event event)
+{
+    std::shared_ptr<Registration> reg;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = registrations_.find(id);
+        if (it == registrations_.end())
+            return;
+        reg = it->second;
+        inHandler_ = id;
+    }
+
+    const Handler &handler = event == Event::Readable   ? reg->onReadable
+                             : event == Event::Writable ? reg->onWritable
+                                                        : reg->onTimer;
+    bool keep = !handler || handler();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        inHandler_ = 0;
+        if (!keep)
+            eraseLocked(id);
+        else if (event == Event::Timer)
+            reg->nextTimer = std::chrono::steady_clock::now() + reg->period;
+    }
+    handlerDone_.notify_all();
+}
+
+void NetReactor::reactorThread()
+{
+    blog(LOG_INFO, "[BitrateSceneSwitch] Network reactor running");
+
+    std::vector<Id> ready;
+    std::vector<Id> writable;
+    while (!stopping_) {
+        int waitMs;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            waitMs = waitMsLocked(std::chrono::steady_clock::now());
+        }
+
+        ready.clear();
+        writable.clear();
+#ifdef __linux__
+        epoll_event events[kMaxEvents];
+        int n = epoll_wait(epollFd_, events, kMaxEvents, waitMs);
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u64 == kWakeId) {
+                drainWake();
+                continue;
+            }
+            if (events[i].events & EPOLLOUT)
+                writable.push_back(events[i].data.u64);
+            if (events[i].events & ~EPOLLOUT)
+                ready.push_back(events[i].data.u64);
+        }
+#else
+        std::vector<pollfd> fds;
+        std::vector<Id> ids;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto &entry : registrations_) {
+                short events = POLLIN | (entry.second->wantWritable ? POLLOUT : 0);
+                fds.push_back(pollfd{entry.second->fd, events, 0});
+                ids.push_back(entry.first);
+            }
+        }
+        if (wakeFds_[0] >= 0)
+            fds.push_back(pollfd{wakeFds_[0], POLLIN, 0});
+        int n = poll(fds.data(), static_cast<nfds_t>(fds.size()), waitMs);
+        for (int i = 0; n > 0 && i < static_cast<int>(ids.size()); i++) {
+            if (fds[i].revents & POLLOUT)
+                writable.push_back(ids[i]);
+            if (fds[i].revents & ~POLLOUT)
+                ready.push_back(ids[i]);
+        }
+        if (n > 0 && wakeFds_[0] >= 0 && fds.back().revents)
+            drainWake();
+#endif
+        if (stopping_)
+            break;
+
+        // queued output goes first; errors and hangups count as readable
+        // so the handler sees them
+        for (Id id : writable)
+            dispatch(id, Event::Writable);
+        for (Id id : ready)
+            dispatch(id, Event::Readable);
+
+        ready.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto now = std::chrono::steady_clock::now();
+            for (const auto &entry : registrations_) {
+                if (entry.second->nextTimer <= now)
+                    ready.push_back(entry.first);
+            }
+        }
+        for (Id id : ready)
+            dispatch(id, Event::Timer);
+    }
+}
+
+} // namespace BitrateSwitch
+
+#endif // !_WIN32
@@ -0,0 +1,91 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace BitrateSwitch {
+
+// One thread that waits on every chat, PubSub and WebSocket connection at
+// once (epoll on Linux, poll() on other POSIX systems) and runs each
+// connection's handlers on it: onReadable when its socket has data, onTimer
+// every timerPeriod for pings and liveness checks, and onWritable when the
+// socket can take more output while write interest is switched on. A
+// handler returns false to drop its registration.
+//
+// Not built on Windows: WinHTTP doesn't expose its socket, so the clients
+// keep a thread each there.
+class NetReactor {
+public:
+    using Handler = std::function<bool()>;
+    using Id = uint64_t;
+
+    // Process-wide instance, started on first use and stopped once the
+    // last holder lets go
+    static std::shared_ptr<NetReactor> shared();
+
+    NetReactor();
+    ~NetReactor();
+
+    NetReactor(const NetReactor &) = delete;
+    NetReactor &operator=(const NetReactor &) = delete;
+
+    // The first timer fires right away. Returns 0 on failure.
+    Id add(int fd, Handler onReadable, Handler onTimer, std::chrono::milliseconds timerPeriod,
+           Handler onWritable = nullptr);
+
+    // Switches waiting for writability on or off, e.g. while output is
+    // queued behind a full socket buffer. Unknown ids are ignored.
+    void watchWritable(Id id, bool on);
+
+    // Once this returns neither handler is running or will run again.
+    // Unknown ids are ignored. Handlers drop themselves by returning false
+    // instead of calling this.
+    void remove(Id id);
+
+    // Runs id's timer handler as soon as possible
+    void fireTimer(Id id);
+
+private:
+    struct Registration {
+        int fd = -1;
+        Handler onReadable;
+        Handler onTimer;
+        Handler onWritable;
+        bool wantWritable = false;
+        std::chrono::milliseconds period{1000};
+        std::chrono::steady_clock::time_point nextTimer;
+    };
+
+    void reactorThread();
+    void wake();
+    void drainWake();
+    int waitMsLocked(std::chrono::steady_clock::time_point now) const;
+    enum class Event { Readable, Writable, Timer };
+
+    void dispatch(Id id, Event event);
+    void eraseLocked(Id id);
+
+    std::mutex mutex_;
+    std::condition_variable handlerDone_;
+    std::map<Id, std::shared_ptr<Registration>> registrations_;
+    Id nextId_ = 1;
+    Id inHandler_ = 0; // registration whose handler is running, if any
+
+    std::atomic<bool> stopping_{false};
+    int epollFd_ = -1;            // Linux only
+    int wakeFds_[2] = {-1, -1};   // eventfd on Linux (both ends the same), pipe elsewhere
+    std::thread thread_;
+};
+
+} // namespace BitrateSwitch
+
+#endif // !_WIN32
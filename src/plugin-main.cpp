@@ -9,6 +9,7 @@
 #include <curl/curl.h>
 
 #include "switcher.hpp"
+#include "chat-client.hpp"
 #include "config.hpp"
 #include "settings-dialog.hpp"
 #include "websocket-vendor.hpp"
@@ -100,6 +101,7 @@ bool obs_module_load(void)
     blog(LOG_INFO, "[BitrateSceneSwitch] Plugin loaded (version %s)", PLUGIN_VERSION);
 
     curl_global_init(CURL_GLOBAL_DEFAULT);
+    BitrateSwitch::HttpClient::initShared();
 
     g_config = new BitrateSwitch::Config();
     g_switcher = new BitrateSwitch::Switcher(g_config);
@@ -146,10 +148,13 @@ void obs_module_unload(void)
         g_switcher = nullptr;
     }
 
+    BitrateSwitch::ChatClient::shutdownResolver();
+
     if (g_config) {
         delete g_config;
         g_config = nullptr;
     }
 
+    BitrateSwitch::HttpClient::cleanupShared();
     curl_global_cleanup();
 }
@@ -0,0 +1,356 @@
+#include "poll-engine.hpp"
+#include <obs-module.h>
+#include <util/platform.h>
+#include <algorithm>
+#include <atomic>
+
+namespace BitrateSwitch {
+
+namespace {
+
+// idle handles older than this belong to servers that were removed
+constexpr auto kIdleHandleTtl = std::chrono::seconds(60);
+
+// a response this fresh still counts as "this pass" for an identical
+// request; kept below the fastest adaptive poll interval so sped-up
+// servers always get a new reading
+constexpr auto kCoalesceWindow = std::chrono::milliseconds(100);
+
+std::atomic<uint64_t> g_hedgeEligible{0};
+std::atomic<uint64_t> g_hedgesSent{0};
+std::atomic<uint64_t> g_hedgeWins{0};
+
+// Identity of a request for coalescing. Streaming requests feed their own
+// parser and are never shared.
+std::string coalesceKey(const HttpRequest &request)
+{
+    if (request.onData)
+        return std::string();
+
+    std::string key;
+    key.reserve(request.url.size() + request.authHeader.size() + request.body.size() + 32);
+    key += request.post ? "POST\n" : "GET\n";
+    key += request.url;
+    key += '\n';
+    key += request.authHeader;
+    key += '\n';
+    key += request.body;
+    key += '\n';
+    key += request.compressed ? "z\n" : "\n";
+    key += request.ifNoneMatch;
+    key += '\n';
+    key += request.ifModifiedSince;
+    return key;
+}
+
+} // anonymous namespace
+
+PollEngine::PollEngine()
+{
+    multi_ = curl_multi_init();
+    if (!multi_)
+        blog(LOG_ERROR, "[BitrateSceneSwitch] Failed to initialize CURL multi handle");
+}
+
+PollEngine::~PollEngine()
+{
+    for (auto &entry : transfers_) {
+        curl_multi_remove_handle(multi_, entry.first);
+        curl_easy_cleanup(entry.first);
+        if (entry.second.headers)
+            curl_slist_free_all(entry.second.headers);
+    }
+    for (auto &entry : idle_)
+        curl_easy_cleanup(entry.second.easy);
+    if (multi_)
+        curl_multi_cleanup(multi_);
+}
+
+CURL *PollEngine::acquireHandle(const std::string &host)
+{
+    auto it = idle_.find(host);
+    if (it == idle_.end())
+        return curl_easy_init();
+
+    CURL *easy = it->second.easy;
+    idle_.erase(it);
+    curl_easy_reset(easy);
+    return easy;
+}
+
+void PollEngine::releaseHandle(CURL *easy, Transfer &transfer)
+{
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, nullptr);
+    if (transfer.headers)
+        curl_slist_free_all(transfer.headers);
+    transfer.headers = nullptr;
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = idle_.begin(); it != idle_.end();) {
+        if (now - it->second.since > kIdleHandleTtl) {
+            curl_easy_cleanup(it->second.easy);
+            it = idle_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    idle_.emplace(transfer.host, IdleHandle{easy, now});
+}
+
+void PollEngine::finishOne(const std::shared_ptr<Batch> &batch)
+{
+    if (--batch->remaining == 0 && batch->done)
+        batch->done(std::move(batch->responses));
+}
+
+void PollEngine::submit(const std::vector<HttpRequest> &requests, Completion done)
+{
+    auto batch = std::make_shared<Batch>();
+    batch->responses.resize(requests.size());
+    batch->remaining = requests.size();
+    batch->done = std::move(done);
+
+    if (requests.empty()) {
+        if (batch->done)
+            batch->done(std::move(batch->responses));
+        return;
+    }
+
+    // no multi handle: degrade to serial requests rather than reporting
+    // every server offline
+    if (!multi_) {
+        for (size_t i = 0; i < requests.size(); i++) {
+            batch->responses[i] = fallback_.perform(requests[i]);
+            finishOne(batch);
+        }
+        return;
+    }
+
+    pruneRecent(std::chrono::steady_clock::now());
+
+    for (size_t i = 0; i < requests.size(); i++) {
+        std::string key = coalesceKey(requests[i]);
+        if (!key.empty()) {
+            auto recent = recent_.find(key);
+            if (recent != recent_.end()) {
+                batch->responses[i] = recent->second.response;
+                finishOne(batch);
+                continue;
+            }
+            auto leader = inFlight_.find(key);
+            if (leader != inFlight_.end()) {
+                transfers_[leader->second].waiters.push_back(Waiter{batch, i});
+                continue;
+            }
+        }
+
+        std::string host = HttpClient::hostKey(requests[i].url);
+        CURL *easy = acquireHandle(host);
+        if (!easy) {
+            finishOne(batch);
+            continue;
+        }
+
+        Transfer &transfer = transfers_[easy];
+        transfer.batch = batch;
+        transfer.index = i;
+        transfer.host = std::move(host);
+        transfer.headers = HttpClient::configureHandle(easy, requests[i], &batch->responses[i]);
+        if (!key.empty())
+            inFlight_[key] = easy;
+        transfer.key = std::move(key);
+
+        // a streaming parser can't be fed by two transfers at once
+        const HttpRequest &request = requests[i];
+        if (request.hedgeAfterMs > 0 && request.hedgeAfterMs < request.timeoutMs && !request.onData) {
+            transfer.hedgeRequest = std::make_unique<HttpRequest>(request);
+            transfer.hedgeAt = std::chrono::steady_clock::now() +
+                               std::chrono::milliseconds(request.hedgeAfterMs);
+            g_hedgeEligible++;
+        }
+        curl_multi_add_handle(multi_, easy);
+    }
+}
+
+int PollEngine::launchHedges(std::chrono::steady_clock::time_point now, int timeoutMs)
+{
+    int waitMs = timeoutMs;
+    for (auto &entry : transfers_) {
+        Transfer &original = entry.second;
+        if (!original.hedgeRequest)
+            continue;
+        if (now < original.hedgeAt) {
+            auto until = std::chrono::ceil<std::chrono::milliseconds>(original.hedgeAt - now);
+            waitMs = (std::min)(waitMs, static_cast<int>(until.count()));
+            continue;
+        }
+
+        CURL *easy = acquireHandle(original.host);
+        if (!easy) {
+            original.hedgeRequest.reset();
+            continue;
+        }
+
+        // transfers_ is a map, so adding while iterating is safe; the new
+        // entry has no hedgeRequest and is skipped
+        Transfer &hedge = transfers_[easy];
+        hedge.batch = original.batch;
+        hedge.index = original.index;
+        hedge.host = original.host;
+        hedge.request = std::move(original.hedgeRequest);
+        hedge.request->freshConnection = true;
+        hedge.hedgeResponse = std::make_unique<HttpResponse>();
+        hedge.headers = HttpClient::configureHandle(easy, *hedge.request, hedge.hedgeResponse.get());
+        hedge.twin = entry.first;
+        original.twin = easy;
+        curl_multi_add_handle(multi_, easy);
+        g_hedgesSent++;
+    }
+    return waitMs;
+}
+
+void PollEngine::handOver(Transfer &from, Transfer &to, CURL *toEasy)
+{
+    if (from.key.empty())
+        return;
+    inFlight_[from.key] = toEasy;
+    to.key = std::move(from.key);
+    to.waiters = std::move(from.waiters);
+    from.key.clear();
+    from.waiters.clear();
+}
+
+void PollEngine::pruneRecent(std::chrono::steady_clock::time_point now)
+{
+    for (auto it = recent_.begin(); it != recent_.end();) {
+        if (now - it->second.at > kCoalesceWindow)
+            it = recent_.erase(it);
+        else
+            ++it;
+    }
+}
+
+void PollEngine::shareResult(Transfer &transfer)
+{
+    if (transfer.key.empty())
+        return;
+    inFlight_.erase(transfer.key);
+
+    HttpResponse &response = transfer.batch->responses[transfer.index];
+    response.sink = nullptr;
+    if (!response.sharedBody) {
+        response.sharedBody = std::make_shared<const std::string>(std::move(response.body));
+        response.body.clear();
+    }
+
+    for (Waiter &waiter : transfer.waiters) {
+        waiter.batch->responses[waiter.index] = response;
+        finishOne(waiter.batch);
+    }
+    transfer.waiters.clear();
+
+    // failures aren't worth remembering; the next poll should retry
+    if (response.success || response.notModified)
+        recent_[transfer.key] = Recent{response, std::chrono::steady_clock::now()};
+}
+
+int PollEngine::collectDone()
+{
+    int finished = 0;
+    CURLMsg *msg;
+    int queued = 0;
+    while ((msg = curl_multi_info_read(multi_, &queued)) != nullptr) {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+
+        CURL *easy = msg->easy_handle;
+        CURLcode result = msg->data.result;
+        curl_multi_remove_handle(multi_, easy);
+
+        auto it = transfers_.find(easy);
+        if (it == transfers_.end()) {
+            curl_easy_cleanup(easy);
+            continue;
+        }
+
+        Transfer transfer = std::move(it->second);
+        transfers_.erase(it);
+        HttpResponse *response = transfer.hedgeResponse
+            ? transfer.hedgeResponse.get()
+            : &transfer.batch->responses[transfer.index];
+        HttpClient::finishHandle(easy, result, response);
+        releaseHandle(easy, transfer);
+
+        auto twin = transfer.twin ? transfers_.find(transfer.twin) : transfers_.end();
+        if (twin != transfers_.end()) {
+            twin->second.twin = nullptr;
+            if (!response->success && !response->notModified) {
+                // a failed copy doesn't win; wait for the other one
+                handOver(transfer, twin->second, twin->first);
+                continue;
+            }
+
+            // first answer wins; the slower copy is abandoned mid-transfer
+            handOver(twin->second, transfer, easy);
+            curl_multi_remove_handle(multi_, twin->first);
+            curl_easy_cleanup(twin->first);
+            if (twin->second.headers)
+                curl_slist_free_all(twin->second.headers);
+            transfers_.erase(twin);
+        }
+
+        if (transfer.hedgeResponse) {
+            if (transfer.hedgeResponse->success || transfer.hedgeResponse->notModified)
+                g_hedgeWins++;
+            transfer.batch->responses[transfer.index] = std::move(*transfer.hedgeResponse);
+        }
+        shareResult(transfer);
+        finishOne(transfer.batch);
+        finished++;
+    }
+    return finished;
+}
+
+void PollEngine::run(int timeoutMs)
+{
+    if (!multi_) {
+        os_sleep_ms(static_cast<uint32_t>(timeoutMs));
+        return;
+    }
+
+    // wake up in time for the next hedge
+    timeoutMs = launchHedges(std::chrono::steady_clock::now(), timeoutMs);
+
+    int running = 0;
+    CURLMcode mc = curl_multi_perform(multi_, &running);
+    if (mc == CURLM_OK && collectDone() > 0)
+        return;
+
+    // curl_multi_poll also just sleeps when there is nothing to wait on
+    if (mc == CURLM_OK)
+        mc = curl_multi_poll(multi_, nullptr, 0, timeoutMs, nullptr);
+    if (mc == CURLM_OK && running)
+        mc = curl_multi_perform(multi_, &running);
+    if (mc != CURLM_OK) {
+        blog(LOG_WARNING, "[BitrateSceneSwitch] curl multi failed: %s", curl_multi_strerror(mc));
+        return;
+    }
+    collectDone();
+}
+
+void PollEngine::wakeup()
+{
+    if (multi_)
+        curl_multi_wakeup(multi_);
+}
+
+HedgeStats PollEngine::hedgeStats()
+{
+    HedgeStats stats;
+    stats.eligible = g_hedgeEligible.load();
+    stats.sent = g_hedgesSent.load();
+    stats.wins = g_hedgeWins.load();
+    return stats;
+}
+
+} // namespace BitrateSwitch
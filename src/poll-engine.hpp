@@ -0,0 +1,125 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#include "http-client.hpp"
+
+namespace BitrateSwitch {
+
+// Runs stats requests concurrently on one curl multi handle. Requests are
+// submitted in batches (one per server poll); a batch's completion fires
+// once all of its responses are in, independently of every other batch,
+// so a slow server never holds up a fast one.
+//
+// Identical requests (same method, URL, auth, body and validators) that
+// are in flight together or land within one sampler pass share a single
+// transfer; every requester gets the same read-only body.
+//
+// A request with hedgeAfterMs set gets a second copy on a fresh
+// connection once it has been running that long. Whichever copy answers
+// first is used and the other is dropped.
+
+// Process-wide hedging counters: how many requests could have been
+// hedged, how many were, and how many of those the hedge answered first
+struct HedgeStats {
+    uint64_t eligible = 0;
+    uint64_t sent = 0;
+    uint64_t wins = 0;
+};
+
+class PollEngine {
+public:
+    using Completion = std::function<void(std::vector<HttpResponse> &&responses)>;
+
+    PollEngine();
+    ~PollEngine();
+
+    PollEngine(const PollEngine &) = delete;
+    PollEngine &operator=(const PollEngine &) = delete;
+
+    // Completions run on the thread that calls run(). An empty batch
+    // completes immediately.
+    void submit(const std::vector<HttpRequest> &requests, Completion done);
+
+    // Drives in-flight transfers. Waits at most timeoutMs for activity
+    // (or just sleeps that long when nothing is in flight).
+    void run(int timeoutMs);
+
+    // Makes a run() in progress on another thread return early.
+    // Safe to call from any thread.
+    void wakeup();
+
+    bool busy() const { return !transfers_.empty(); }
+
+    static HedgeStats hedgeStats();
+
+private:
+    struct Batch {
+        std::vector<HttpResponse> responses;
+        size_t remaining = 0;
+        Completion done;
+    };
+
+    struct Waiter {
+        std::shared_ptr<Batch> batch;
+        size_t index = 0;
+    };
+
+    struct Transfer {
+        std::shared_ptr<Batch> batch;
+        size_t index = 0;
+        curl_slist *headers = nullptr;
+        std::string host;
+        std::string key;  // empty when the request can't be shared
+        std::vector<Waiter> waiters;
+
+        // Hedging: the original keeps its request until the copy goes
+        // out, then the copy owns it for as long as its handle runs. The
+        // copy writes into its own response. twin links the two.
+        std::unique_ptr<HttpRequest> hedgeRequest;
+        std::unique_ptr<HttpRequest> request;
+        std::chrono::steady_clock::time_point hedgeAt;
+        std::unique_ptr<HttpResponse> hedgeResponse;
+        CURL *twin = nullptr;
+    };
+
+    struct Recent {
+        HttpResponse response;
+        std::chrono::steady_clock::time_point at;
+    };
+
+    struct IdleHandle {
+        CURL *easy = nullptr;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    CURL *acquireHandle(const std::string &host);
+    void releaseHandle(CURL *easy, Transfer &transfer);
+    void finishOne(const std::shared_ptr<Batch> &batch);
+    int collectDone();
+    void shareResult(Transfer &transfer);
+    void pruneRecent(std::chrono::steady_clock::time_point now);
+    int launchHedges(std::chrono::steady_clock::time_point now, int timeoutMs);
+    void handOver(Transfer &from, Transfer &to, CURL *toEasy);
+
+    CURLM *multi_ = nullptr;
+    std::map<CURL *, Transfer> transfers_;
+
+    // Easy handles between polls, keyed by host. Reusing them keeps their
+    // keep-alive connections; hosts nobody polls any more age out.
+    std::multimap<std::string, IdleHandle> idle_;
+
+    // Coalescing: leaders of shareable in-flight transfers, and recently
+    // completed shareable responses
+    std::map<std::string, CURL *> inFlight_;
+    std::map<std::string, Recent> recent_;
+
+    HttpClient fallback_;
+};
+
+} // namespace BitrateSwitch
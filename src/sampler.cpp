@@ -0,0 +1,249 @@
+#include "sampler.hpp"
+#include <obs-module.h>
+#include <algorithm>
+
+namespace BitrateSwitch {
+
+namespace {
+
+constexpr auto kPollInterval = std::chrono::milliseconds(1000);
+// adaptive cadence: ~7 Hz near a trigger, every 3 s once settled
+constexpr auto kFastInterval = std::chrono::milliseconds(150);
+constexpr auto kSlowInterval = std::chrono::milliseconds(3000);
+// how long a reading has to hold before polling slows down
+constexpr auto kSettleTime = std::chrono::seconds(10);
+// upper bound on how long the thread sleeps, so new servers are picked
+// up promptly; stop() wakes it directly
+constexpr int kMaxWaitMs = 100;
+
+// Within margin of a trigger, or moving toward one by more than the
+// margin since the last reading
+bool nearTrigger(const BitrateInfo &info, const BitrateInfo &last, const CadencePolicy &cadence)
+{
+    const Triggers &t = cadence.triggers;
+    double margin = cadence.marginPercent / 100.0;
+    double kbps = static_cast<double>(info.bitrateKbps);
+
+    if (t.low > 0 && kbps <= t.low * (1.0 + margin))
+        return true;
+    if (t.offline > 0 && kbps <= t.offline * (1.0 + margin))
+        return true;
+    if (t.rtt > 0 && info.rttMs >= t.rtt * (1.0 - margin))
+        return true;
+    if (t.rttOffline > 0 && info.rttMs >= t.rttOffline * (1.0 - margin))
+        return true;
+
+    if (last.isOnline && last.bitrateKbps > 0 && kbps < last.bitrateKbps * (1.0 - margin))
+        return true;
+    // small RTTs jitter by large ratios; only watch the trend once it matters
+    if (t.rtt > 0 && info.rttMs >= t.rtt / 2.0 && last.rttMs > 0 &&
+        info.rttMs > last.rttMs * (1.0 + margin))
+        return true;
+    return false;
+}
+
+// A poll fails when the server didn't answer any of its requests. A
+// clean "publisher offline" reply is still a healthy server.
+void recordOutcome(StreamServer &server, const std::vector<HttpResponse> &responses)
+{
+    // nothing was fetched (data shared with another entry)
+    if (responses.empty()) {
+        server.breaker().cancelProbe();
+        return;
+    }
+
+    bool answered = std::any_of(responses.begin(), responses.end(),
+                                [](const HttpResponse &response) {
+                                    return response.success || response.notModified;
+                                });
+
+    CircuitBreaker &breaker = server.breaker();
+    CircuitBreaker::State before = breaker.state();
+    if (answered)
+        breaker.recordSuccess();
+    else
+        breaker.recordFailure(std::chrono::steady_clock::now());
+
+    CircuitBreaker::State after = breaker.state();
+    if (after == before)
+        return;
+    if (after == CircuitBreaker::State::Open) {
+        auto snap = breaker.snapshot(std::chrono::steady_clock::now());
+        blog(LOG_WARNING, "[BitrateSceneSwitch] %s: not responding, next try in %lld ms",
+             server.getName().c_str(), static_cast<long long>(snap.retryInMs));
+    } else if (after == CircuitBreaker::State::Closed) {
+        blog(LOG_INFO, "[BitrateSceneSwitch] %s: responding again", server.getName().c_str());
+    }
+}
+
+} // anonymous namespace
+
+Sampler::Sampler()
+{
+}
+
+Sampler::~Sampler()
+{
+    stop();
+}
+
+void Sampler::start()
+{
+    if (running_)
+        return;
+
+    running_ = true;
+    thread_ = std::thread(&Sampler::samplerThread, this);
+}
+
+void Sampler::stop()
+{
+    running_ = false;
+    engine_.wakeup();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void Sampler::setServers(const std::vector<std::shared_ptr<StreamServer>> &servers)
+{
+    std::lock_guard<std::mutex> lock(entriesMutex_);
+
+    // servers kept across a reload keep their schedule and in-flight state
+    std::vector<std::shared_ptr<Entry>> entries;
+    entries.reserve(servers.size());
+    for (const auto &server : servers) {
+        auto it = std::find_if(entries_.begin(), entries_.end(),
+                               [&](const std::shared_ptr<Entry> &entry) {
+                                   return entry->server == server;
+                               });
+        std::shared_ptr<Entry> entry;
+        if (it != entries_.end()) {
+            entry = *it;
+        } else {
+            entry = std::make_shared<Entry>();
+            entry->server = server;
+        }
+        entry->primary = server->isBackup() ? server->getDependsOn().serverName : std::string();
+        entries.push_back(std::move(entry));
+    }
+    entries_ = std::move(entries);
+}
+
+void Sampler::setFetchOptions(const FetchOptions &options)
+{
+    std::lock_guard<std::mutex> lock(entriesMutex_);
+    fetchOptions_ = options;
+}
+
+void Sampler::setCadence(const CadencePolicy &cadence)
+{
+    std::lock_guard<std::mutex> lock(entriesMutex_);
+    cadence_ = cadence;
+}
+
+void Sampler::updateCadence(Entry &entry, const BitrateInfo &info, const CadencePolicy &cadence)
+{
+    auto now = std::chrono::steady_clock::now();
+    bool online = info.isOnline && info.bitrateKbps > 0;
+
+    Reading reading = Reading::Offline;
+    if (online)
+        reading = nearTrigger(info, entry.last, cadence) ? Reading::Busy : Reading::Live;
+    if (reading != entry.reading) {
+        entry.reading = reading;
+        entry.readingSince = now;
+    }
+    entry.last = info;
+    entry.last.backups.clear();
+
+    if (!cadence.adaptive)
+        entry.interval = kPollInterval;
+    else if (reading == Reading::Busy)
+        entry.interval = kFastInterval;
+    else if (now - entry.readingSince >= kSettleTime)
+        // never so slow that the switcher sees the reading as stale
+        entry.interval = (std::min)(kSlowInterval, (std::max)(kPollInterval,
+                                    std::chrono::milliseconds(cadence.staleSampleMs / 2)));
+    else
+        entry.interval = kPollInterval;
+}
+
+std::chrono::milliseconds Sampler::pollDue(std::chrono::steady_clock::time_point now)
+{
+    std::vector<std::shared_ptr<Entry>> entries;
+    std::vector<std::string> primaries;
+    FetchOptions options;
+    CadencePolicy cadence;
+    {
+        std::lock_guard<std::mutex> lock(entriesMutex_);
+        entries = entries_;
+        for (const auto &entry : entries_)
+            primaries.push_back(entry->primary);
+        options = fetchOptions_;
+        cadence = cadence_;
+    }
+
+    auto due = [now](const Entry &entry) {
+        return !entry.inFlight && now >= entry.nextDue && !entry.server->pushesStats();
+    };
+    std::vector<std::string> duePrimaries;
+    for (const auto &entry : entries) {
+        if (due(*entry))
+            duePrimaries.push_back(entry->server->getName());
+    }
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        const std::shared_ptr<Entry> &entry = entries[i];
+        bool withPrimary = !primaries[i].empty() && !entry->inFlight &&
+                           !entry->server->pushesStats() &&
+                           std::find(duePrimaries.begin(), duePrimaries.end(), primaries[i]) !=
+                               duePrimaries.end();
+        if (!due(*entry) && !withPrimary)
+            continue;
+        // an open breaker keeps the slot empty; it goes stale and reads as offline
+        if (!entry->server->breaker().allow(now))
+            continue;
+
+        entry->inFlight = true;
+        // keep the cadence anchored to the start of the poll, but never
+        // queue up catch-up polls after a long timeout
+        entry->nextDue = now + (cadence.adaptive ? entry->interval : kPollInterval);
+        // only the primary is worth the extra load of hedging
+        FetchOptions entryOptions = options;
+        entryOptions.hedge = options.hedge && entry == entries.front();
+        engine_.submit(entry->server->pollRequests(entryOptions),
+                       [entry, cadence](std::vector<HttpResponse> &&responses) {
+                           recordOutcome(*entry->server, responses);
+                           BitrateInfo info = entry->server->pollResult(responses);
+                           updateCadence(*entry, info, cadence);
+                           entry->server->publish(info);
+                           entry->inFlight = false;
+                       });
+    }
+
+    // entries still overdue here are held back (breaker open) and wait
+    // for the regular wake-up
+    auto next = std::chrono::milliseconds(kMaxWaitMs);
+    for (const auto &entry : entries) {
+        if (entry->inFlight || entry->server->pushesStats() || entry->nextDue <= now)
+            continue;
+        next = (std::min)(next, std::chrono::ceil<std::chrono::milliseconds>(entry->nextDue - now));
+    }
+    return next;
+}
+
+void Sampler::samplerThread()
+{
+    blog(LOG_INFO, "[BitrateSceneSwitch] Sampler thread running");
+
+    while (running_) {
+        auto now = std::chrono::steady_clock::now();
+        int waitMs = kMaxWaitMs;
+        if (enabled_)
+            waitMs = static_cast<int>(pollDue(now).count());
+
+        engine_.run(waitMs);
+    }
+}
+
+} // namespace BitrateSwitch
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "stream-server.hpp"
+#include "poll-engine.hpp"
+
+namespace BitrateSwitch {
+
+// How often each server is polled. With adaptive off every server is
+// polled once a second; with it on, a server near (or heading for) one of
+// the triggers is polled several times a second and one that has been
+// steadily live or steadily offline drops to every few seconds.
+struct CadencePolicy {
+    bool adaptive = false;
+    uint32_t marginPercent = 25;   // how close to a trigger counts as "near"
+    uint32_t staleSampleMs = 5000; // slow polling stays well inside this
+    Triggers triggers;
+};
+
+// Polls every server on its own schedule and publishes each result into
+// that server's latest-sample slot. The switcher never waits on this: it
+// only reads the slots. All servers share one thread and one curl multi
+// handle, so a server stuck in a timeout delays nobody else.
+class Sampler {
+public:
+    Sampler();
+    ~Sampler();
+
+    void start();
+    void stop();
+
+    void setServers(const std::vector<std::shared_ptr<StreamServer>> &servers);
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    void setFetchOptions(const FetchOptions &options);
+    void setCadence(const CadencePolicy &cadence);
+
+private:
+    // What the last reading said, for picking the next interval
+    enum class Reading { Unknown, Busy, Live, Offline };
+
+    struct Entry {
+        std::shared_ptr<StreamServer> server;
+        std::chrono::steady_clock::time_point nextDue;
+        bool inFlight = false;
+
+        // Sampler thread only
+        std::chrono::milliseconds interval{1000};
+        Reading reading = Reading::Unknown;
+        std::chrono::steady_clock::time_point readingSince;
+        BitrateInfo last;
+
+        // backups go out together with their primary so both readings
+        // are equally fresh when the primary drops; guarded by entriesMutex_
+        std::string primary;
+    };
+
+    void samplerThread();
+    // Returns how long until the next server is due
+    std::chrono::milliseconds pollDue(std::chrono::steady_clock::time_point now);
+    static void updateCadence(Entry &entry, const BitrateInfo &info, const CadencePolicy &cadence);
+
+    PollEngine engine_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> enabled_{true};
+
+    std::mutex entriesMutex_;
+    std::vector<std::shared_ptr<Entry>> entries_;
+    FetchOptions fetchOptions_;
+    CadencePolicy cadence_;
+};
+
+} // namespace BitrateSwitch
@@ -0,0 +1,53 @@
+#include "server-reload.hpp"
+
+namespace BitrateSwitch {
+
+uint64_t hashServerConfig(const StreamServerConfig &config)
+{
+    // FNV-1a; fields are separated so "ab"+"c" and "a"+"bc" differ
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const std::string &field) {
+        for (unsigned char c : field) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        hash ^= 0xff;
+        hash *= 1099511628211ULL;
+    };
+
+    mix(std::to_string(static_cast<int>(config.type)));
+    mix(config.name);
+    mix(config.statsUrl);
+    mix(config.publisher);
+    mix(config.application);
+    mix(config.key);
+    mix(config.id);
+    mix(config.authUser);
+    mix(config.authPass);
+    return hash;
+}
+
+std::vector<size_t> planServerReload(const std::vector<RunningServer> &running,
+                                     const std::vector<StreamServerConfig> &configs)
+{
+    std::vector<size_t> plan(configs.size(), kNewServer);
+    std::vector<bool> taken(running.size(), false);
+
+    for (size_t i = 0; i < configs.size(); i++) {
+        const StreamServerConfig &config = configs[i];
+        if (!config.enabled)
+            continue;
+
+        uint64_t hash = hashServerConfig(config);
+        for (size_t j = 0; j < running.size(); j++) {
+            if (!taken[j] && running[j].name == config.name && running[j].configHash == hash) {
+                taken[j] = true;
+                plan[i] = j;
+                break;
+            }
+        }
+    }
+    return plan;
+}
+
+} // namespace BitrateSwitch
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "config.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace BitrateSwitch {
+
+// Hash of the server fields that decide what gets polled and how. Scene
+// overrides are left out: they can be updated on a live server in place.
+uint64_t hashServerConfig(const StreamServerConfig &config);
+
+// What a running server is matched on when the config is reloaded
+struct RunningServer {
+    std::string name;
+    uint64_t configHash = 0;
+};
+
+constexpr size_t kNewServer = (std::numeric_limits<size_t>::max)();
+
+// For each entry of configs, the index of the running server it keeps, or
+// kNewServer when one has to be built. A server is kept when its name and
+// hashServerConfig() are unchanged, and at most once. Disabled entries
+// are always kNewServer; the caller skips them.
+std::vector<size_t> planServerReload(const std::vector<RunningServer> &running,
+                                     const std::vector<StreamServerConfig> &configs);
+
+} // namespace BitrateSwitch
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../stream-server.hpp"
+#include "../json-scan.hpp"
 
 namespace BitrateSwitch {
 
@@ -9,11 +10,12 @@ public:
     explicit BelaboxServer(const StreamServerConfig &config);
     ~BelaboxServer() override = default;
 
-    SwitchType checkSwitch(const Triggers &triggers) override;
-    BitrateInfo getBitrate() override;
+    std::vector<HttpRequest> statsRequests() override;
+    BitrateInfo parseStats(const std::vector<HttpResponse> &responses) override;
 
 private:
-    BitrateInfo fetchStats();
+    std::vector<std::string> publishers_;
+    std::vector<JsonQuery> publisherQueries_;  // views into publishers_
 };
 
 } // namespace BitrateSwitch
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../stream-server.hpp"
+#include "../json-scan.hpp"
 
 namespace BitrateSwitch {
 
@@ -10,11 +11,12 @@ public:
     explicit IrlHostingServer(const StreamServerConfig &config);
     ~IrlHostingServer() override = default;
 
-    SwitchType checkSwitch(const Triggers &triggers) override;
-    BitrateInfo getBitrate() override;
+    std::vector<HttpRequest> statsRequests() override;
+    BitrateInfo parseStats(const std::vector<HttpResponse> &responses) override;
 
 private:
-    BitrateInfo fetchStats();
+    std::vector<std::string> publishers_;
+    std::vector<JsonQuery> publisherQueries_;  // views into publishers_
     std::string apiKey_;
 };
 
@@ -1,60 +1,90 @@
 #include "mediamtx.hpp"
-#include "../switcher.hpp"
+#include "../json-scan.hpp"
 #include <cmath>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
 #include <obs-module.h>
 
-namespace {
+namespace BitrateSwitch {
 
-std::string extractJsonValue(const std::string &json, const std::string &key)
-{
-    std::string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey);
-    if (keyPos == std::string::npos) return "";
+// The parsed /v3/paths/list and /v3/srtconns/list of one MediaMTX
+// instance, shared by every server entry that points at it. Every entry
+// requests both lists; the poll engine folds identical requests into one
+// transfer, so entries polled together get the same body and only the
+// first of them has to index it. Only touched from the sampler thread,
+// the mutex just keeps that honest.
+struct MediamtxInstance {
+    std::mutex mutex;
+
+    // Bodies the indexes below were built from
+    std::shared_ptr<const std::string> pathsBody;
+    std::shared_ptr<const std::string> srtConnsBody;
+    // Views into pathsBody
+    std::unordered_map<std::string_view, std::string_view> pathsByName;
+    std::unordered_map<std::string, double> rttBySourceId;
+
+    void update(const HttpResponse &paths, const HttpResponse &srtConns);
+};
 
-    size_t colonPos = json.find(':', keyPos);
-    if (colonPos == std::string::npos) return "";
+namespace {
 
-    size_t valueStart = json.find_first_not_of(" \t\n\r", colonPos + 1);
-    if (valueStart == std::string::npos) return "";
+std::mutex g_instancesMutex;
+std::map<std::string, std::weak_ptr<MediamtxInstance>> g_instances;
 
-    if (json[valueStart] == '"') {
-        size_t valueEnd = json.find('"', valueStart + 1);
-        if (valueEnd == std::string::npos) return "";
-        return json.substr(valueStart + 1, valueEnd - valueStart - 1);
+std::shared_ptr<MediamtxInstance> instanceFor(const std::string &baseUrl)
+{
+    std::lock_guard<std::mutex> lock(g_instancesMutex);
+    std::shared_ptr<MediamtxInstance> instance = g_instances[baseUrl].lock();
+    if (!instance) {
+        instance = std::make_shared<MediamtxInstance>();
+        g_instances[baseUrl] = instance;
     }
 
-    size_t valueEnd = json.find_first_of(",}\n\r]", valueStart);
-    if (valueEnd == std::string::npos) valueEnd = json.length();
-    
-    std::string value = json.substr(valueStart, valueEnd - valueStart);
-    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
-        value.pop_back();
-    return value;
+    for (auto it = g_instances.begin(); it != g_instances.end();) {
+        if (it->second.expired()) it = g_instances.erase(it);
+        else ++it;
+    }
+    return instance;
 }
 
-std::string extractNestedObject(const std::string &json, const std::string &key)
+// The response's body as a shared string, reusing the engine's copy when
+// the transfer was coalesced
+std::shared_ptr<const std::string> sharedText(const HttpResponse &response)
 {
-    std::string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey);
-    if (keyPos == std::string::npos) return "";
-
-    size_t bracePos = json.find('{', keyPos);
-    if (bracePos == std::string::npos) return "";
-
-    int depth = 1;
-    size_t endPos = bracePos + 1;
-    while (depth > 0 && endPos < json.length()) {
-        if (json[endPos] == '{') depth++;
-        else if (json[endPos] == '}') depth--;
-        endPos++;
-    }
-
-    return json.substr(bracePos, endPos - bracePos);
+    if (response.sharedBody) return response.sharedBody;
+    return std::make_shared<const std::string>(response.body);
 }
 
 } // anonymous namespace
 
-namespace BitrateSwitch {
+void MediamtxInstance::update(const HttpResponse &paths, const HttpResponse &srtConns)
+{
+    if (!paths.sharedBody || paths.sharedBody != pathsBody) {
+        pathsByName.clear();
+        pathsBody = sharedText(paths);
+        jsonForEach(jsonFind(*pathsBody, {"items"}), [this](std::string_view item) {
+            std::string_view name = jsonFind(item, {"name"});
+            if (!name.empty()) pathsByName.emplace(name, item);
+            return true;
+        });
+    }
+
+    // Keep the last known RTTs if only the connection list failed
+    if (!srtConns.success) return;
+    if (srtConns.sharedBody && srtConns.sharedBody == srtConnsBody) return;
+    srtConnsBody = sharedText(srtConns);
+    rttBySourceId.clear();
+    jsonForEach(jsonFind(*srtConnsBody, {"items"}), [this](std::string_view conn) {
+        JsonQuery fields[] = {{"id"}, {"msRTT"}};
+        jsonScan(conn, fields);
+        double rtt = 0.0;
+        if (!fields[0].value.empty() && jsonToDouble(fields[1].value, rtt))
+            rttBySourceId[std::string(fields[0].value)] = rtt;
+        return true;
+    });
+}
 
 MediamtxServer::MediamtxServer(const StreamServerConfig &config)
 {
@@ -65,69 +95,88 @@ MediamtxServer::MediamtxServer(const StreamServerConfig &config)
     authPass_ = config.authPass;
     overrideScenes_ = config.overrideScenes;
     lastTimestamp_ = std::chrono::steady_clock::now();
-}
 
-double MediamtxServer::fetchSrtRtt(const std::string &sourceId)
-{
-    // Derive the SRT stats URL from the main stats URL
-    // e.g. http://localhost:9997/v3/paths/get/mystream -> http://localhost:9997/v3/srtconns/get/{id}
+    // e.g. http://localhost:9997/v3/paths/get -> http://localhost:9997;
+    // without a v3 API base we fall back to fetching the single path
     size_t v3Pos = statsUrl_.find("/v3");
-    if (v3Pos == std::string::npos) return 0.0;
-
-    std::string srtUrl = statsUrl_.substr(0, v3Pos) + "/v3/srtconns/get/" + sourceId;
+    if (v3Pos != std::string::npos) {
+        std::string baseUrl = statsUrl_.substr(0, v3Pos);
+        pathsListUrl_ = baseUrl + "/v3/paths/list";
+        srtConnsListUrl_ = baseUrl + "/v3/srtconns/list";
+        instance_ = instanceFor(baseUrl);
+    }
+}
 
-    HttpResponse response = httpClient_.get(srtUrl);
-    if (!response.success) return 0.0;
+MediamtxServer::~MediamtxServer() = default;
 
-    std::string rttStr = extractJsonValue(response.body, "msRTT");
-    if (!rttStr.empty()) {
-        try {
-            return std::stod(rttStr);
-        } catch (...) {
-            return 0.0;
+std::vector<HttpRequest> MediamtxServer::statsRequests()
+{
+    if (!instance_) {
+        // Build the full URL: statsUrl/publisher (e.g. /v3/paths/get/mystream)
+        std::string url = statsUrl_;
+        if (!publisher_.empty()) {
+            if (url.back() != '/') url += '/';
+            url += publisher_;
         }
+
+        HttpRequest request;
+        request.url = url;
+        return {request};
     }
-    return 0.0;
+
+    // Both lists go out together and overlap in the poll engine; other
+    // entries on this instance asking at the same time share the transfers
+    HttpRequest paths;
+    paths.url = pathsListUrl_;
+    HttpRequest srtConns;
+    srtConns.url = srtConnsListUrl_;
+    return {paths, srtConns};
 }
 
-BitrateInfo MediamtxServer::fetchStats()
+BitrateInfo MediamtxServer::parseStats(const std::vector<HttpResponse> &responses)
 {
     BitrateInfo info;
     info.serverName = name_;
 
-    // Build the full URL: statsUrl/publisher (e.g. /v3/paths/get/mystream)
-    std::string url = statsUrl_;
-    if (!publisher_.empty()) {
-        if (url.back() != '/') url += '/';
-        url += publisher_;
-    }
+    if (responses.empty() || !responses[0].success) return info;
+    if (!instance_) return parsePath(responses[0].text(), nullptr);
+    if (responses.size() != 2) return info;
 
-    HttpResponse response = httpClient_.get(url);
-    if (!response.success) return info;
+    std::lock_guard<std::mutex> lock(instance_->mutex);
+    instance_->update(responses[0], responses[1]);
 
-    std::string readyStr = extractJsonValue(response.body, "ready");
-    if (readyStr != "true") return info;
+    auto it = instance_->pathsByName.find(publisher_);
+    if (it == instance_->pathsByName.end()) return info;
+    return parsePath(it->second, &instance_->rttBySourceId);
+}
 
-    // Check if source is SRT for RTT stats
-    std::string sourceObj = extractNestedObject(response.body, "source");
-    if (!sourceObj.empty()) {
-        std::string sourceType = extractJsonValue(sourceObj, "type");
-        std::string sourceId = extractJsonValue(sourceObj, "id");
-        if (sourceType == "srtConn" && !sourceId.empty()) {
-            info.rttMs = fetchSrtRtt(sourceId);
-        }
+BitrateInfo MediamtxServer::parsePath(std::string_view path,
+                                      const std::unordered_map<std::string, double> *rttBySourceId)
+{
+    BitrateInfo info;
+    info.serverName = name_;
+
+    JsonQuery fields[] = {
+        {"ready"},
+        {"source", "type"},
+        {"source", "id"},
+        {"bytesReceived"},
+    };
+    jsonScan(path, fields);
+
+    if (fields[0].value != "true") return info;
+
+    // SRT publishers carry an RTT in the connection list
+    if (rttBySourceId && fields[1].value == "srtConn" && !fields[2].value.empty()) {
+        auto rtt = rttBySourceId->find(std::string(fields[2].value));
+        if (rtt != rttBySourceId->end())
+            info.rttMs = rtt->second;
     }
 
     // Calculate bitrate from bytesReceived delta over time
-    std::string bytesReceivedStr = extractJsonValue(response.body, "bytesReceived");
-    if (bytesReceivedStr.empty()) return info;
-
-    uint64_t bytesReceived;
-    try {
-        bytesReceived = std::stoull(bytesReceivedStr);
-    } catch (...) {
-        return info;
-    }
+    int64_t received = 0;
+    if (!jsonToInt(fields[3].value, received) || received < 0) return info;
+    uint64_t bytesReceived = static_cast<uint64_t>(received);
 
     if (bytesReceived == prevBytesReceived_ && cacheInitialized_) {
         // no new data since last poll, return cached bitrate instead of reporting offline
@@ -165,22 +214,13 @@ BitrateInfo MediamtxServer::fetchStats()
     return info;
 }
 
-SwitchType MediamtxServer::checkSwitch(const Triggers &triggers)
+std::string MediamtxServer::describe(const BitrateInfo &info)
 {
-    BitrateInfo info = fetchStats();
-    return evaluateTriggers(info, triggers);
-}
-
-BitrateInfo MediamtxServer::getBitrate()
-{
-    BitrateInfo info = fetchStats();
-    if (info.bitrateKbps > 0) {
-        info.message = std::to_string(info.bitrateKbps) + " kbps";
-        if (info.rttMs > 0) {
-            info.message += ", " + std::to_string(static_cast<int>(std::round(info.rttMs))) + " ms";
-        }
-    }
-    return info;
+    if (info.bitrateKbps <= 0) return "";
+    std::string message = std::to_string(info.bitrateKbps) + " kbps";
+    if (info.rttMs > 0)
+        message += ", " + std::to_string(static_cast<int>(std::round(info.rttMs))) + " ms";
+    return message;
 }
 
 } // namespace BitrateSwitch
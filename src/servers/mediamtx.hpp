@@ -2,20 +2,34 @@
 
 #include "../stream-server.hpp"
 #include <chrono>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
 
 namespace BitrateSwitch {
 
+struct MediamtxInstance;
+
+// With a /v3 API URL every entry on the same MediaMTX instance asks for
+// /v3/paths/list + /v3/srtconns/list; entries polled together share one
+// fetch and one parsed index, and RTT is looked up by source id instead of
+// a request per path.
 class MediamtxServer : public StreamServer {
 public:
     explicit MediamtxServer(const StreamServerConfig &config);
-    ~MediamtxServer() override = default;
+    ~MediamtxServer() override;
 
-    SwitchType checkSwitch(const Triggers &triggers) override;
-    BitrateInfo getBitrate() override;
+    std::vector<HttpRequest> statsRequests() override;
+    BitrateInfo parseStats(const std::vector<HttpResponse> &responses) override;
+    std::string describe(const BitrateInfo &info) override;
 
 private:
-    BitrateInfo fetchStats();
-    double fetchSrtRtt(const std::string &sourceId);
+    BitrateInfo parsePath(std::string_view path,
+                          const std::unordered_map<std::string, double> *rttBySourceId);
+
+    std::string pathsListUrl_;
+    std::string srtConnsListUrl_;
+    std::shared_ptr<MediamtxInstance> instance_;
 
     // Cache for bitrate calculation from bytesReceived delta
     uint64_t prevBytesReceived_ = 0;
@@ -1,96 +1,230 @@
 #include "nginx.hpp"
-#include "../switcher.hpp"
+#include <cstdlib>
 
 namespace {
 
-std::string extractXmlValue(const std::string &xml, const std::string &tag)
+constexpr size_t kMaxCapture = 256;
+
+bool isXmlSpace(char c)
 {
-    std::string openTag = "<" + tag + ">";
-    std::string closeTag = "</" + tag + ">";
-    
-    size_t start = xml.find(openTag);
-    if (start == std::string::npos) return "";
-    
-    start += openTag.length();
-    size_t end = xml.find(closeTag, start);
-    if (end == std::string::npos) return "";
-    
-    return xml.substr(start, end - start);
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
 }
 
-std::string findStreamByName(const std::string &xml, const std::string &name)
+std::string_view trimmed(std::string_view s)
 {
-    size_t pos = 0;
-    while (pos < xml.length()) {
-        size_t streamStart = xml.find("<stream>", pos);
-        if (streamStart == std::string::npos) break;
-        
-        size_t streamEnd = xml.find("</stream>", streamStart);
-        if (streamEnd == std::string::npos) break;
-        
-        std::string streamBlock = xml.substr(streamStart, streamEnd - streamStart + 9);
-        std::string streamName = extractXmlValue(streamBlock, "name");
-        
-        if (streamName == name) return streamBlock;
-        
-        pos = streamEnd + 9;
-    }
-    return "";
+    while (!s.empty() && isXmlSpace(s.front())) s.remove_prefix(1);
+    while (!s.empty() && isXmlSpace(s.back())) s.remove_suffix(1);
+    return s;
 }
 
 } // anonymous namespace
 
 namespace BitrateSwitch {
 
+NginxStatScanner::NginxStatScanner(std::string application, std::string stream)
+    : application_(std::move(application))
+    , stream_(std::move(stream))
+{
+}
+
+bool NginxStatScanner::feed(std::string_view chunk)
+{
+    for (size_t i = 0; i < chunk.size() && !done_; ++i) {
+        char c = chunk[i];
+
+        switch (state_) {
+        case State::Text:
+            if (c == '<') {
+                state_ = State::TagName;
+                closing_ = false;
+                selfClosing_ = false;
+                tagLength_ = 0;
+                tagTruncated_ = false;
+            } else if (capture_ != Capture::None && text_.size() < kMaxCapture) {
+                text_ += c;
+            }
+            break;
+
+        case State::TagName:
+            if (c == '/' && tagLength_ == 0 && !closing_) {
+                closing_ = true;
+            } else if ((c == '?' || c == '!') && tagLength_ == 0) {
+                // Declarations, comments and processing instructions
+                state_ = State::Skip;
+            } else if (c == '>' || c == '/' || isXmlSpace(c)) {
+                state_ = State::Tag;
+                --i;  // let Tag handle the terminator
+            } else if (tagLength_ < sizeof(tagName_)) {
+                tagName_[tagLength_++] = c;
+            } else {
+                tagTruncated_ = true;
+            }
+            break;
+
+        case State::Tag:
+            if (c == '>') {
+                state_ = State::Text;
+                std::string_view tag = tagTruncated_ ? std::string_view()
+                                                     : std::string_view(tagName_, tagLength_);
+                if (closing_) {
+                    closeTag();
+                } else {
+                    openTag(tag);
+                    if (selfClosing_) closeTag();
+                }
+            } else if (c == '/') {
+                selfClosing_ = true;
+            } else if (!isXmlSpace(c)) {
+                selfClosing_ = false;
+            }
+            break;
+
+        case State::Skip:
+            if (c == '>') state_ = State::Text;
+            break;
+        }
+    }
+    return !done_;
+}
+
+void NginxStatScanner::openTag(std::string_view tag)
+{
+    ++depth_;
+
+    if (tag == "application" && streamDepth_ == 0) {
+        appDepth_ = depth_;
+        appMatches_ = application_.empty();
+    } else if (tag == "stream" && appMatches_ && streamDepth_ == 0) {
+        streamDepth_ = depth_;
+        nameMatches_ = false;
+        streamActive_ = false;
+        haveBw_ = false;
+        streamBw_ = 0;
+    } else if (tag == "name") {
+        if (streamDepth_ != 0 && depth_ == streamDepth_ + 1)
+            capture_ = Capture::StreamName;
+        else if (appDepth_ != 0 && streamDepth_ == 0 && depth_ == appDepth_ + 1)
+            capture_ = Capture::AppName;
+    } else if (tag == "bw_video" && streamDepth_ != 0 && depth_ == streamDepth_ + 1) {
+        capture_ = Capture::BwVideo;
+    } else if (tag == "active" && streamDepth_ != 0) {
+        // Clients of an active stream carry <active/> too; either will do
+        streamActive_ = true;
+    }
+
+    if (capture_ != Capture::None)
+        text_.clear();
+}
+
+void NginxStatScanner::closeTag()
+{
+    if (capture_ != Capture::None)
+        finishCapture();
+
+    if (streamDepth_ != 0 && depth_ == streamDepth_) {
+        finishStream();
+        streamDepth_ = 0;
+    } else if (appDepth_ != 0 && depth_ == appDepth_) {
+        appDepth_ = 0;
+        appMatches_ = false;
+    }
+
+    if (depth_ > 0) --depth_;
+
+    // Everything we want from the target stream is in; skip the rest
+    if (streamDepth_ != 0 && nameMatches_ && haveBw_ && streamActive_)
+        finishStream();
+}
+
+void NginxStatScanner::finishCapture()
+{
+    std::string_view text = trimmed(text_);
+
+    switch (capture_) {
+    case Capture::AppName:
+        appMatches_ = application_.empty() || text == application_;
+        break;
+    case Capture::StreamName:
+        nameMatches_ = text == stream_;
+        break;
+    case Capture::BwVideo: {
+        std::string value(text);
+        char *end = nullptr;
+        long long bw = std::strtoll(value.c_str(), &end, 10);
+        if (end != value.c_str()) {
+            streamBw_ = bw;
+            haveBw_ = true;
+        }
+        break;
+    }
+    case Capture::None:
+        break;
+    }
+
+    capture_ = Capture::None;
+}
+
+void NginxStatScanner::finishStream()
+{
+    if (!nameMatches_) return;
+
+    found_ = true;
+    active_ = streamActive_;
+    bwVideo_ = haveBw_ ? streamBw_ : 0;
+    done_ = true;
+}
+
 NginxServer::NginxServer(const StreamServerConfig &config)
 {
     statsUrl_ = config.statsUrl;
     publisher_ = config.key;
     name_ = config.name;
     overrideScenes_ = config.overrideScenes;
-    
+
+    // "app/stream" pins the application; a bare stream name matches in any
     size_t slashPos = publisher_.find('/');
     if (slashPos != std::string::npos) {
         application_ = publisher_.substr(0, slashPos);
         publisher_ = publisher_.substr(slashPos + 1);
-    } else {
-        application_ = "live";
     }
 }
 
-BitrateInfo NginxServer::fetchStats()
+std::vector<HttpRequest> NginxServer::statsRequests()
+{
+    // The stat page lists every stream on the box; scan it while it
+    // downloads and drop the connection once our stream has been read
+    auto scanner = std::make_shared<NginxStatScanner>(application_, publisher_);
+    scanner_ = scanner;
+
+    HttpRequest request;
+    request.url = statsUrl_;
+    request.onData = [scanner](std::string_view chunk) { return scanner->feed(chunk); };
+    return {request};
+}
+
+BitrateInfo NginxServer::parseStats(const std::vector<HttpResponse> &responses)
 {
     BitrateInfo info;
 
-    HttpResponse response = httpClient_.get(statsUrl_);
+    if (responses.empty()) return info;
+    const HttpResponse &response = responses[0];
     if (!response.success) return info;
 
-    std::string streamBlock = findStreamByName(response.body, publisher_);
-    if (streamBlock.empty()) return info;
+    std::shared_ptr<NginxStatScanner> scanner = std::move(scanner_);
+    if (!scanner) return info;
 
-    // Check if the stream has an <active/> tag (indicates actively publishing)
-    bool hasActive = streamBlock.find("<active") != std::string::npos;
-    if (!hasActive) return info;
+    // An <active/> tag means the stream is actively publishing
+    if (!scanner->found() || !scanner->active()) return info;
 
     // Use bw_video (bits/s) converted to kbps
-    std::string bwVideoStr = extractXmlValue(streamBlock, "bw_video");
-    if (!bwVideoStr.empty()) {
-        try {
-            int64_t bwVideo = std::stoll(bwVideoStr);
-            info.bitrateKbps = bwVideo / 1024;
-        } catch (...) {
-            info.bitrateKbps = 0;
-        }
-    }
+    info.bitrateKbps = scanner->bwVideo() / 1024;
 
     info.isOnline = true;
     return info;
 }
 
-SwitchType NginxServer::checkSwitch(const Triggers &triggers)
+SwitchType NginxServer::evaluate(const BitrateInfo &info, const Triggers &triggers)
 {
-    BitrateInfo info = fetchStats();
-
     if (!info.isOnline)
         return SwitchType::Offline;
 
@@ -101,13 +235,10 @@ SwitchType NginxServer::checkSwitch(const Triggers &triggers)
     return evaluateTriggers(info, triggers);
 }
 
-BitrateInfo NginxServer::getBitrate()
+std::string NginxServer::describe(const BitrateInfo &info)
 {
-    BitrateInfo info = fetchStats();
-    if (info.bitrateKbps > 0) {
-        info.message = std::to_string(info.bitrateKbps) + " kbps";
-    }
-    return info;
+    if (info.bitrateKbps <= 0) return "";
+    return std::to_string(info.bitrateKbps) + " kbps";
 }
 
 } // namespace BitrateSwitch
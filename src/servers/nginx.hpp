@@ -1,20 +1,81 @@
 #pragma once
 
 #include "../stream-server.hpp"
+#include <string_view>
 
 namespace BitrateSwitch {
 
+// SAX-style scanner for nginx-rtmp's /stat XML. It can be fed the page in
+// arbitrary chunks (tags may be split across them), only looks at streams
+// inside the wanted <application>, copies nothing but the few text nodes
+// it needs, and reports done() as soon as the target stream's <bw_video>
+// and <active/> have been seen or its </stream> has closed.
+class NginxStatScanner {
+public:
+    // An empty application matches every application
+    NginxStatScanner(std::string application, std::string stream);
+
+    // Returns false once the rest of the document is no longer needed
+    bool feed(std::string_view chunk);
+
+    bool done() const { return done_; }
+    bool found() const { return found_; }
+    bool active() const { return active_; }
+    int64_t bwVideo() const { return bwVideo_; }
+
+private:
+    enum class State { Text, TagName, Tag, Skip };
+    enum class Capture { None, AppName, StreamName, BwVideo };
+
+    void openTag(std::string_view tag);
+    void closeTag();
+    void finishCapture();
+    void finishStream();
+
+    std::string application_;
+    std::string stream_;
+
+    State state_ = State::Text;
+    bool closing_ = false;
+    bool selfClosing_ = false;
+    char tagName_[16] = {};
+    size_t tagLength_ = 0;
+    bool tagTruncated_ = false;
+    char prev_ = 0;
+
+    Capture capture_ = Capture::None;
+    std::string text_;
+
+    int depth_ = 0;
+    int appDepth_ = 0;
+    bool appMatches_ = false;
+    int streamDepth_ = 0;
+    bool nameMatches_ = false;
+    bool streamActive_ = false;
+    bool haveBw_ = false;
+    int64_t streamBw_ = 0;
+
+    bool done_ = false;
+    bool found_ = false;
+    bool active_ = false;
+    int64_t bwVideo_ = 0;
+};
+
 class NginxServer : public StreamServer {
 public:
     explicit NginxServer(const StreamServerConfig &config);
     ~NginxServer() override = default;
 
-    SwitchType checkSwitch(const Triggers &triggers) override;
-    BitrateInfo getBitrate() override;
+    std::vector<HttpRequest> statsRequests() override;
+    BitrateInfo parseStats(const std::vector<HttpResponse> &responses) override;
+    SwitchType evaluate(const BitrateInfo &info, const Triggers &triggers) override;
+    std::string describe(const BitrateInfo &info) override;
 
 private:
-    BitrateInfo fetchStats();
     std::string application_;
+
+    // Fed straight from the transfer by statsRequests(), read by parseStats()
+    std::shared_ptr<NginxStatScanner> scanner_;
 };
 
 } // namespace BitrateSwitch
@@ -1,58 +1,7 @@
 #include "nimble.hpp"
-#include "../switcher.hpp"
+#include "../json-scan.hpp"
 #include <cmath>
 
-namespace {
-
-std::string extractJsonValue(const std::string &json, const std::string &key)
-{
-    std::string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey);
-    if (keyPos == std::string::npos) return "";
-
-    size_t colonPos = json.find(':', keyPos);
-    if (colonPos == std::string::npos) return "";
-
-    size_t valueStart = json.find_first_not_of(" \t\n\r", colonPos + 1);
-    if (valueStart == std::string::npos) return "";
-
-    if (json[valueStart] == '"') {
-        size_t valueEnd = json.find('"', valueStart + 1);
-        if (valueEnd == std::string::npos) return "";
-        return json.substr(valueStart + 1, valueEnd - valueStart - 1);
-    }
-
-    size_t valueEnd = json.find_first_of(",}\n\r]", valueStart);
-    if (valueEnd == std::string::npos) valueEnd = json.length();
-    
-    std::string value = json.substr(valueStart, valueEnd - valueStart);
-    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
-        value.pop_back();
-    return value;
-}
-
-std::string extractNestedObject(const std::string &json, const std::string &key)
-{
-    std::string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey);
-    if (keyPos == std::string::npos) return "";
-
-    size_t bracePos = json.find('{', keyPos);
-    if (bracePos == std::string::npos) return "";
-
-    int depth = 1;
-    size_t endPos = bracePos + 1;
-    while (depth > 0 && endPos < json.length()) {
-        if (json[endPos] == '{') depth++;
-        else if (json[endPos] == '}') depth--;
-        endPos++;
-    }
-
-    return json.substr(bracePos, endPos - bracePos);
-}
-
-} // anonymous namespace
-
 namespace BitrateSwitch {
 
 NimbleServer::NimbleServer(const StreamServerConfig &config)
@@ -65,85 +14,64 @@ NimbleServer::NimbleServer(const StreamServerConfig &config)
     overrideScenes_ = config.overrideScenes;
 }
 
-BitrateInfo NimbleServer::fetchStats()
+std::vector<HttpRequest> NimbleServer::statsRequests()
+{
+    // SRT receiver stats carry the RTT, RTMP status carries the bandwidth;
+    // both go out together so the poll engine can overlap them
+    HttpRequest srt;
+    srt.url = statsUrl_ + "/manage/srt_receiver_stats";
+    HttpRequest rtmp;
+    rtmp.url = statsUrl_ + "/manage/rtmp_status";
+    return {srt, rtmp};
+}
+
+BitrateInfo NimbleServer::parseStats(const std::vector<HttpResponse> &responses)
 {
     BitrateInfo info;
     info.serverName = name_;
 
-    // Fetch SRT receiver stats
-    std::string srtUrl = statsUrl_ + "/manage/srt_receiver_stats";
-    HttpResponse srtResponse = httpClient_.get(srtUrl);
+    if (responses.size() < 2) return info;
+    const HttpResponse &srtResponse = responses[0];
+    const HttpResponse &rtmpResponse = responses[1];
     if (!srtResponse.success) return info;
 
+    std::string_view srtBody = srtResponse.text();
+
     // Find receiver matching our ID
-    size_t idPos = srtResponse.body.find("\"id\":\"" + id_);
-    if (idPos == std::string::npos) return info;
+    size_t idPos = srtBody.find("\"id\":\"" + id_);
+    if (idPos == std::string_view::npos) return info;
 
-    // Check state
-    size_t statePos = srtResponse.body.find("\"state\":", idPos);
-    if (statePos != std::string::npos) {
-        std::string stateBlock = srtResponse.body.substr(statePos, 50);
-        if (stateBlock.find("disconnected") != std::string::npos) {
-            return info;
-        }
-    }
+    // Scan the rest of that receiver's object for its state and link RTT
+    JsonQuery receiver[] = {{"state"}, {"link", "rtt"}};
+    jsonScan(srtBody.substr(idPos), receiver);
 
-    // wrap the whole number-crunching section so one bad value
-    // doesn't nuke the switcher thread
-    try {
-        std::string linkStats = extractNestedObject(srtResponse.body.substr(idPos), "link");
-        if (!linkStats.empty()) {
-            std::string rttStr = extractJsonValue(linkStats, "rtt");
-            if (!rttStr.empty())
-                info.rttMs = std::stod(rttStr);
-        }
+    if (receiver[0].value.find("disconnected") != std::string_view::npos)
+        return info;
 
-        std::string rtmpUrl = statsUrl_ + "/manage/rtmp_status";
-        HttpResponse rtmpResponse = httpClient_.get(rtmpUrl);
-        if (rtmpResponse.success) {
-            size_t appPos = rtmpResponse.body.find("\"app\":\"" + application_ + "\"");
-            if (appPos != std::string::npos) {
-                size_t strmPos = rtmpResponse.body.find("\"strm\":\"" + key_ + "\"", appPos);
-                if (strmPos != std::string::npos) {
-                    size_t bwPos = rtmpResponse.body.rfind("\"bandwidth\":", strmPos);
-                    if (bwPos != std::string::npos && bwPos > appPos) {
-                        std::string bwStr = extractJsonValue(rtmpResponse.body.substr(bwPos), "bandwidth");
-                        if (!bwStr.empty()) {
-                            if (bwStr.front() == '"') bwStr = bwStr.substr(1, bwStr.size() - 2);
-                            int64_t bw = std::stoll(bwStr);
-                            info.bitrateKbps = bw / 1024;
-                        }
-                    }
+    jsonToDouble(receiver[1].value, info.rttMs);
+
+    if (rtmpResponse.success) {
+        std::string_view rtmpBody = rtmpResponse.text();
+        size_t appPos = rtmpBody.find("\"app\":\"" + application_ + "\"");
+        if (appPos != std::string_view::npos) {
+            size_t strmPos = rtmpBody.find("\"strm\":\"" + key_ + "\"", appPos);
+            if (strmPos != std::string_view::npos) {
+                size_t bwPos = rtmpBody.rfind("\"bandwidth\":", strmPos);
+                if (bwPos != std::string_view::npos && bwPos > appPos) {
+                    int64_t bw = 0;
+                    if (jsonToInt(jsonFind(rtmpBody.substr(bwPos), {"bandwidth"}), bw))
+                        info.bitrateKbps = bw / 1024;
                 }
             }
         }
-    } catch (...) {
-        return info;
     }
 
     info.isOnline = info.bitrateKbps > 0 || info.rttMs > 0;
     return info;
 }
 
-SwitchType NimbleServer::checkSwitch(const Triggers &triggers)
-{
-    BitrateInfo info = fetchStats();
-    return evaluateTriggers(info, triggers);
-}
-
-BitrateInfo NimbleServer::getBitrate()
-{
-    BitrateInfo info = fetchStats();
-    if (info.bitrateKbps > 0) {
-        info.message = std::to_string(info.bitrateKbps) + " kbps, " + 
-                       std::to_string(static_cast<int>(std::round(info.rttMs))) + " ms";
-    }
-    return info;
-}
-
-std::string NimbleServer::getSourceInfo()
+std::string NimbleServer::getSourceInfo(const BitrateInfo &info)
 {
-    BitrateInfo info = fetchStats();
     if (!info.isOnline) return "Offline";
     
     return std::to_string(info.bitrateKbps) + " Kbps, " +
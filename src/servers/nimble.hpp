@@ -10,12 +10,9 @@ public:
     explicit NimbleServer(const StreamServerConfig &config);
     ~NimbleServer() override = default;
 
-    SwitchType checkSwitch(const Triggers &triggers) override;
-    BitrateInfo getBitrate() override;
-    std::string getSourceInfo() override;
-
-private:
-    BitrateInfo fetchStats();
+    std::vector<HttpRequest> statsRequests() override;
+    BitrateInfo parseStats(const std::vector<HttpResponse> &responses) override;
+    std::string getSourceInfo(const BitrateInfo &info) override;
 };
 
 } // namespace BitrateSwitch
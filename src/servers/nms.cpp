@@ -1,36 +1,5 @@
 #include "nms.hpp"
-#include "../switcher.hpp"
-
-namespace {
-
-std::string extractJsonValue(const std::string &json, const std::string &key)
-{
-    std::string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey);
-    if (keyPos == std::string::npos) return "";
-
-    size_t colonPos = json.find(':', keyPos);
-    if (colonPos == std::string::npos) return "";
-
-    size_t valueStart = json.find_first_not_of(" \t\n\r", colonPos + 1);
-    if (valueStart == std::string::npos) return "";
-
-    if (json[valueStart] == '"') {
-        size_t valueEnd = json.find('"', valueStart + 1);
-        if (valueEnd == std::string::npos) return "";
-        return json.substr(valueStart + 1, valueEnd - valueStart - 1);
-    }
-
-    size_t valueEnd = json.find_first_of(",}\n\r", valueStart);
-    if (valueEnd == std::string::npos) valueEnd = json.length();
-    
-    std::string value = json.substr(valueStart, valueEnd - valueStart);
-    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
-        value.pop_back();
-    return value;
-}
-
-} // anonymous namespace
+#include "../json-scan.hpp"
 
 namespace BitrateSwitch {
 
@@ -45,11 +14,8 @@ NmsServer::NmsServer(const StreamServerConfig &config)
     overrideScenes_ = config.overrideScenes;
 }
 
-BitrateInfo NmsServer::fetchStats()
+std::vector<HttpRequest> NmsServer::statsRequests()
 {
-    BitrateInfo info;
-    info.serverName = name_;
-
     // Build URL: statsUrl/application/key
     std::string url = statsUrl_;
     if (!application_.empty()) {
@@ -61,30 +27,34 @@ BitrateInfo NmsServer::fetchStats()
         url += key_;
     }
 
-    HttpResponse response = httpClient_.get(url);
+    HttpRequest request;
+    request.url = url;
+    return {request};
+}
+
+BitrateInfo NmsServer::parseStats(const std::vector<HttpResponse> &responses)
+{
+    BitrateInfo info;
+    info.serverName = name_;
+
+    if (responses.empty()) return info;
+    const HttpResponse &response = responses[0];
     if (!response.success) return info;
 
     // Parse NMS JSON response
-    std::string isLiveStr = extractJsonValue(response.body, "isLive");
-    std::string bitrateStr = extractJsonValue(response.body, "bitrate");
+    JsonQuery fields[] = {{"isLive"}, {"bitrate"}};
+    jsonScan(response.text(), fields);
 
-    if (isLiveStr != "true") return info;
+    if (fields[0].value != "true") return info;
 
-    try {
-        if (!bitrateStr.empty())
-            info.bitrateKbps = std::stoll(bitrateStr);
-    } catch (...) {
-        return info;
-    }
+    jsonToInt(fields[1].value, info.bitrateKbps);
 
     info.isOnline = info.bitrateKbps > 0;
     return info;
 }
 
-SwitchType NmsServer::checkSwitch(const Triggers &triggers)
+SwitchType NmsServer::evaluate(const BitrateInfo &info, const Triggers &triggers)
 {
-    BitrateInfo info = fetchStats();
-    
     // NMS: bitrate 0 means return to previous
     if (info.isOnline && info.bitrateKbps == 0)
         return SwitchType::Previous;
@@ -92,13 +62,10 @@ SwitchType NmsServer::checkSwitch(const Triggers &triggers)
     return evaluateTriggers(info, triggers);
 }
 
-BitrateInfo NmsServer::getBitrate()
+std::string NmsServer::describe(const BitrateInfo &info)
 {
-    BitrateInfo info = fetchStats();
-    if (info.bitrateKbps > 0) {
-        info.message = std::to_string(info.bitrateKbps) + " kbps";
-    }
-    return info;
+    if (info.bitrateKbps <= 0) return "";
+    return std::to_string(info.bitrateKbps) + " kbps";
 }
 
 } // namespace BitrateSwitch
@@ -10,11 +10,10 @@ public:
     explicit NmsServer(const StreamServerConfig &config);
     ~NmsServer() override = default;
 
-    SwitchType checkSwitch(const Triggers &triggers) override;
-    BitrateInfo getBitrate() override;
-
-private:
-    BitrateInfo fetchStats();
+    std::vector<HttpRequest> statsRequests() override;
+    BitrateInfo parseStats(const std::vector<HttpResponse> &responses) override;
+    SwitchType evaluate(const BitrateInfo &info, const Triggers &triggers) override;
+    std::string describe(const BitrateInfo &info) override;
 };
 
 } // namespace BitrateSwitch
@@ -0,0 +1,76 @@
+#include "publishers.hpp"
+#include "../json-scan.hpp"
+
+namespace BitrateSwitch {
+
+namespace {
+
+enum Field { Bitrate, Rtt, Dropped, MbpsBandwidth, MbpsRecvRate, BytesLost, FieldCount };
+
+} // anonymous namespace
+
+std::vector<std::string> splitPublisherKeys(const std::string &keys)
+{
+    std::vector<std::string> result;
+    size_t start = 0;
+    while (start <= keys.size()) {
+        size_t end = keys.find(',', start);
+        if (end == std::string::npos) end = keys.size();
+
+        size_t first = keys.find_first_not_of(" \t", start);
+        size_t last = keys.find_last_not_of(" \t", end == 0 ? 0 : end - 1);
+        if (first != std::string::npos && first < end && last >= first)
+            result.push_back(keys.substr(first, last - first + 1));
+
+        start = end + 1;
+    }
+    return result;
+}
+
+std::vector<JsonQuery> publisherQueries(const std::vector<std::string> &keys,
+                                        const PublisherFields &fields)
+{
+    const std::string_view names[FieldCount] = {"bitrate", "rtt", fields.dropped, "mbps_bandwidth",
+                                                "mbps_recv_rate", "bytes_rcv_loss"};
+
+    std::vector<JsonQuery> queries;
+    queries.reserve(keys.size() * FieldCount);
+    for (const std::string &key : keys) {
+        for (int f = 0; f < FieldCount; f++) {
+            bool wanted = !names[f].empty() && (fields.srtBandwidth || f <= Dropped);
+            // unwanted fields get an empty path, which jsonScan skips
+            queries.push_back(wanted ? JsonQuery{"publishers", key, names[f]} : JsonQuery{});
+        }
+    }
+    return queries;
+}
+
+BitrateInfo parsePublishers(std::string_view body, const std::vector<std::string> &keys,
+                            std::vector<JsonQuery> &queries)
+{
+    if (keys.empty() || queries.size() != keys.size() * FieldCount) return BitrateInfo();
+
+    // one pass over the body answers every query
+    jsonScan(body, queries.data(), queries.size());
+
+    BitrateInfo primary;
+    if (keys.size() > 1)
+        primary.backups.resize(keys.size() - 1);
+    for (size_t k = 0; k < keys.size(); k++) {
+        const JsonQuery *q = &queries[k * FieldCount];
+        BitrateInfo &info = k == 0 ? primary : primary.backups[k - 1];
+        info.publisher = keys[k];
+
+        // unparsable values just keep their defaults
+        jsonToInt(q[Bitrate].value, info.bitrateKbps);
+        jsonToDouble(q[Rtt].value, info.rttMs);
+        jsonToInt(q[Dropped].value, info.droppedPackets);
+        jsonToDouble(q[MbpsBandwidth].value, info.mbpsBandwidth);
+        jsonToDouble(q[MbpsRecvRate].value, info.mbpsRecvRate);
+        jsonToInt(q[BytesLost].value, info.bytesLost);
+        info.isOnline = info.bitrateKbps > 0;
+    }
+    return primary;
+}
+
+} // namespace BitrateSwitch
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../stream-server.hpp"
+#include "../json-scan.hpp"
+#include <string_view>
+
+namespace BitrateSwitch {
+
+// SLS, BELABOX and IRLHosting all report every publisher of the box in one
+// "publishers" map. A server entry may watch several of them: the key field
+// then holds a comma-separated list, highest priority first.
+std::vector<std::string> splitPublisherKeys(const std::string &keys);
+
+// Which stats fields a server reports besides bitrate and rtt
+struct PublisherFields {
+    std::string_view dropped;     // packet drop counter
+    bool srtBandwidth = false;    // mbps_bandwidth, mbps_recv_rate, bytes_rcv_loss
+};
+
+// The keys x fields queries parsePublishers() runs, built once per server
+// when its key list is set. They point into keys, which has to stay put
+// for as long as they are used, and carry scan state, so each server
+// keeps its own list.
+std::vector<JsonQuery> publisherQueries(const std::vector<std::string> &keys,
+                                        const PublisherFields &fields);
+
+// Reads every listed publisher from body in a single scan. The first key
+// comes back as the result; the others, in order, as its backups.
+BitrateInfo parsePublishers(std::string_view body, const std::vector<std::string> &keys,
+                            std::vector<JsonQuery> &queries);
+
+} // namespace BitrateSwitch
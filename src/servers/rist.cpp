@@ -1,150 +1,70 @@
 #include "rist.hpp"
-#include "../switcher.hpp"
+#include "../json-scan.hpp"
 #include "ws-client.hpp"
+#include <algorithm>
 #include <cmath>
-#include <functional>
 #include <obs-module.h>
 
-namespace {
-
-std::string extractJsonValue(const std::string &json, const std::string &key)
-{
-    std::string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey);
-    if (keyPos == std::string::npos) return "";
-
-    size_t colonPos = json.find(':', keyPos);
-    if (colonPos == std::string::npos) return "";
-
-    size_t valueStart = json.find_first_not_of(" \t\n\r", colonPos + 1);
-    if (valueStart == std::string::npos) return "";
-
-    if (json[valueStart] == '"') {
-        size_t valueEnd = json.find('"', valueStart + 1);
-        if (valueEnd == std::string::npos) return "";
-        return json.substr(valueStart + 1, valueEnd - valueStart - 1);
-    }
-
-    size_t valueEnd = json.find_first_of(",}\n\r]", valueStart);
-    if (valueEnd == std::string::npos) valueEnd = json.length();
-
-    std::string value = json.substr(valueStart, valueEnd - valueStart);
-    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
-        value.pop_back();
-    return value;
-}
-
-std::string extractNestedObject(const std::string &json, const std::string &key)
-{
-    std::string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey);
-    if (keyPos == std::string::npos) return "";
-
-    size_t bracePos = json.find('{', keyPos);
-    if (bracePos == std::string::npos) return "";
-
-    int depth = 1;
-    size_t endPos = bracePos + 1;
-    while (depth > 0 && endPos < json.length()) {
-        if (json[endPos] == '{') depth++;
-        else if (json[endPos] == '}') depth--;
-        endPos++;
-    }
-
-    return json.substr(bracePos, endPos - bracePos);
-}
+namespace BitrateSwitch {
 
-std::string extractJsonArray(const std::string &json, const std::string &key)
+RistServer::RistServer(const StreamServerConfig &config)
 {
-    std::string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey);
-    if (keyPos == std::string::npos) return "";
-
-    size_t bracketPos = json.find('[', keyPos);
-    if (bracketPos == std::string::npos) return "";
+    statsUrl_ = config.statsUrl;
+    name_ = config.name;
+    overrideScenes_ = config.overrideScenes;
 
-    int depth = 1;
-    size_t endPos = bracketPos + 1;
-    while (depth > 0 && endPos < json.length()) {
-        if (json[endPos] == '[') depth++;
-        else if (json[endPos] == ']') depth--;
-        endPos++;
+    webSocket_ = isWebSocketUrl();
+    if (webSocket_) {
+        ws_ = std::make_unique<WsClient>();
+        running_ = true;
+        wsThread_ = std::thread(&RistServer::wsThread, this);
     }
-
-    return json.substr(bracketPos, endPos - bracketPos);
 }
 
-void forEachObjectInArray(const std::string &arrayJson,
-                          const std::function<void(const std::string &)> &fn)
+RistServer::~RistServer()
 {
-    size_t pos = 0;
-    while (pos < arrayJson.length()) {
-        size_t objStart = arrayJson.find('{', pos);
-        if (objStart == std::string::npos) break;
-
-        int depth = 1;
-        size_t endPos = objStart + 1;
-        while (depth > 0 && endPos < arrayJson.length()) {
-            if (arrayJson[endPos] == '{') depth++;
-            else if (arrayJson[endPos] == '}') depth--;
-            endPos++;
-        }
-
-        std::string obj = arrayJson.substr(objStart, endPos - objStart);
-        fn(obj);
-        pos = endPos;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        running_ = false;
     }
+    wake_.notify_all();
+    if (ws_)
+        ws_->interrupt();
+    if (wsThread_.joinable())
+        wsThread_.join();
 }
 
-} // anonymous namespace
-
-namespace BitrateSwitch {
-
-RistServer::RistServer(const StreamServerConfig &config)
+bool RistServer::isWebSocketUrl() const
 {
-    statsUrl_ = config.statsUrl;
-    name_ = config.name;
-    overrideScenes_ = config.overrideScenes;
+    // WebSocket URLs start with ws:// or wss://
+    return statsUrl_.compare(0, 5, "ws://") == 0 ||
+           statsUrl_.compare(0, 6, "wss://") == 0;
 }
 
-// ----------- HTTP implementation -----------
-BitrateInfo RistServer::fetchStatsHttp()
+BitrateInfo RistServer::parseReceiverStats(std::string_view json)
 {
     BitrateInfo info;
     info.serverName = name_;
 
-    HttpResponse response = httpClient_.get(statsUrl_);
-    if (!response.success) return info;
-
-    std::string receiverStats = extractNestedObject(response.body, "receiver-stats");
-    if (receiverStats.empty()) return info;
-
-    std::string flowinstant = extractNestedObject(receiverStats, "flowinstant");
-    if (flowinstant.empty()) return info;
-
-    std::string peersArray = extractJsonArray(flowinstant, "peers");
+    std::string_view peersArray = jsonFind(json, {"receiver-stats", "flowinstant", "peers"});
     if (peersArray.empty()) return info;
 
     int64_t totalBitrate = 0;
     double totalRtt = 0.0;
     int peerCount = 0;
 
-    forEachObjectInArray(peersArray, [&](const std::string &peerObj) {
-        std::string statsObj = extractNestedObject(peerObj, "stats");
-        if (statsObj.empty()) return;
-
-        std::string bitrateStr = extractJsonValue(statsObj, "bitrate");
-        std::string rttStr = extractJsonValue(statsObj, "rtt");
+    jsonForEach(peersArray, [&](std::string_view peer) {
+        JsonQuery fields[] = {{"stats", "bitrate"}, {"stats", "rtt"}};
+        if (jsonScan(peer, fields) == 0) return true;
 
-        try {
-            if (!bitrateStr.empty())
-                totalBitrate += std::stoll(bitrateStr);
-            if (!rttStr.empty())
-                totalRtt += std::stod(rttStr);
-        } catch (...) {
-            return;
-        }
+        int64_t bitrate = 0;
+        double rtt = 0.0;
+        jsonToInt(fields[0].value, bitrate);
+        jsonToDouble(fields[1].value, rtt);
+        totalBitrate += bitrate;
+        totalRtt += rtt;
         peerCount++;
+        return true;
     });
 
     if (peerCount == 0) return info;
@@ -156,115 +76,93 @@ BitrateInfo RistServer::fetchStatsHttp()
     return info;
 }
 
-// ----------- WebSocket implementation -----------
-BitrateInfo RistServer::fetchStatsWs()
+// ----------- HTTP implementation -----------
+std::vector<HttpRequest> RistServer::statsRequests()
 {
-    BitrateInfo info;
-    info.serverName = name_;
-
-    // 1. Open WebSocket connection
-    WsClient ws;
-    if (!ws.connect(statsUrl_))
-        return info;
-
-    // 2. Send the same handshake the browser uses
-    ws.send("Connection Established");
-
-    // 3. Wait for the first complete JSON message (server pushes immediately)
-    std::string message;
-    for (int retries = 0; retries < 20; ++retries) {
-        std::string chunk;
-        WsClient::RecvResult res = ws.recv(chunk);
-        if (res == WsClient::RecvResult::Message) {
-            message += chunk;
-            break;
-        } else if (res == WsClient::RecvResult::Error ||
-                   res == WsClient::RecvResult::Closed) {
-            break;
-        }
-        // Timeout → try again
-    }
-
-    ws.disconnect();
-
-    if (message.empty())
-        return info;
-
-    // 4. Parse JSON – same structure as HTTP response body
-    std::string receiverStats = extractNestedObject(message, "receiver-stats");
-    if (receiverStats.empty()) return info;
-
-    std::string flowinstant = extractNestedObject(receiverStats, "flowinstant");
-    if (flowinstant.empty()) return info;
+    if (webSocket_)
+        return {};
 
-    std::string peersArray = extractJsonArray(flowinstant, "peers");
-    if (peersArray.empty()) return info;
-
-    int64_t totalBitrate = 0;
-    double totalRtt = 0.0;
-    int peerCount = 0;
-
-    forEachObjectInArray(peersArray, [&](const std::string &peerObj) {
-        std::string statsObj = extractNestedObject(peerObj, "stats");
-        if (statsObj.empty()) return;
-
-        std::string bitrateStr = extractJsonValue(statsObj, "bitrate");
-        std::string rttStr = extractJsonValue(statsObj, "rtt");
-
-        try {
-            if (!bitrateStr.empty())
-                totalBitrate += std::stoll(bitrateStr);
-            if (!rttStr.empty())
-                totalRtt += std::stod(rttStr);
-        } catch (...) {
-            return;
-        }
-        peerCount++;
-    });
+    HttpRequest request;
+    request.url = statsUrl_;
+    return {request};
+}
 
-    if (peerCount == 0)
+BitrateInfo RistServer::parseStats(const std::vector<HttpResponse> &responses)
+{
+    if (responses.empty() || !responses[0].success) {
+        BitrateInfo info;
+        info.serverName = name_;
         return info;
+    }
 
-    info.bitrateKbps = totalBitrate / 1024;
-    info.rttMs = totalRtt / peerCount;
-    info.isOnline = info.bitrateKbps > 0;
-
-    return info;
+    return parseReceiverStats(responses[0].text());
 }
 
-// ----------- Dispatcher -----------
-BitrateInfo RistServer::fetchStats()
+// ----------- WebSocket implementation -----------
+bool RistServer::waitForRetry(std::chrono::milliseconds delay)
 {
-    // WebSocket URLs start with ws:// or wss://
-    if (statsUrl_.compare(0, 5, "ws://")  == 0 ||
-        statsUrl_.compare(0, 6, "wss://") == 0)
-    {
-        return fetchStatsWs();
-    }
-
-    // Fallback to original HTTP behaviour
-    return fetchStatsHttp();
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    wake_.wait_for(lock, delay, [this] { return !running_; });
+    return running_;
 }
 
-SwitchType RistServer::checkSwitch(const Triggers &triggers)
+void RistServer::publishOffline()
 {
-    BitrateInfo info = fetchStats();
-    return evaluateTriggers(info, triggers);
+    BitrateInfo info;
+    info.serverName = name_;
+    publish(info);
 }
 
-BitrateInfo RistServer::getBitrate()
+void RistServer::wsThread()
 {
-    BitrateInfo info = fetchStats();
-    if (info.bitrateKbps > 0) {
-        info.message = std::to_string(info.bitrateKbps) + " kbps, " +
-                       std::to_string(static_cast<int>(std::round(info.rttMs))) + " ms";
+    constexpr auto kMinBackoff = std::chrono::milliseconds(1000);
+    constexpr auto kMaxBackoff = std::chrono::milliseconds(30000);
+    auto backoff = kMinBackoff;
+
+    while (running_) {
+        WsClient &ws = *ws_;
+        if (!ws.connect(statsUrl_)) {
+            publishOffline();
+            if (!waitForRetry(backoff))
+                break;
+            backoff = (std::min)(backoff * 2, kMaxBackoff);
+            continue;
+        }
+
+        // Same handshake the browser uses; the server then keeps pushing
+        ws.send("Connection Established");
+        blog(LOG_INFO, "[BitrateSceneSwitch] RIST stats session open for %s", name_.c_str());
+
+        while (running_) {
+            std::string message;
+            WsClient::RecvResult res = ws.recv(message);
+            if (res == WsClient::RecvResult::Message) {
+                backoff = kMinBackoff;
+                // greeting replies and other pushed types carry no stats;
+                // treating them as a reading would flap the stream offline
+                if (jsonFind(message, {"receiver-stats"}).empty())
+                    continue;
+                publish(parseReceiverStats(message));
+            } else if (res != WsClient::RecvResult::Timeout) {
+                break;
+            }
+        }
+
+        ws.disconnect();
+        if (!running_)
+            break;
+
+        blog(LOG_WARNING, "[BitrateSceneSwitch] RIST stats session for %s lost, retrying in %lld ms",
+             name_.c_str(), static_cast<long long>(backoff.count()));
+        publishOffline();
+        if (!waitForRetry(backoff))
+            break;
+        backoff = (std::min)(backoff * 2, kMaxBackoff);
     }
-    return info;
 }
 
-std::string RistServer::getSourceInfo()
+std::string RistServer::getSourceInfo(const BitrateInfo &info)
 {
-    BitrateInfo info = fetchStats();
     if (!info.isOnline)
         return "Offline";
 
@@ -1,31 +1,47 @@
 #pragma once
 
 #include "../stream-server.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace BitrateSwitch {
 
+class WsClient;
+
 class RistServer : public StreamServer {
 public:
     explicit RistServer(const StreamServerConfig &config);
-    ~RistServer() override = default;
+    ~RistServer() override;
 
-    SwitchType checkSwitch(const Triggers &triggers) override;
-    BitrateInfo getBitrate() override;
-    std::string getSourceInfo() override;
+    // HTTP stats go through the poll engine. ws:// and wss:// URLs are
+    // read by a background session that publishes every pushed frame,
+    // so the sampler skips them.
+    std::vector<HttpRequest> statsRequests() override;
+    BitrateInfo parseStats(const std::vector<HttpResponse> &responses) override;
+    std::string getSourceInfo(const BitrateInfo &info) override;
+    bool pushesStats() const override { return webSocket_; }
 
 private:
-    // Unified entry point – decides between HTTP and WebSocket
-    BitrateInfo fetchStats();
-
-    // Original HTTP implementation
-    BitrateInfo fetchStatsHttp();
-    // New WebSocket implementation
-    BitrateInfo fetchStatsWs();
-
-    std::string statsUrl_;
-    std::string name_;
-    OverrideScenes overrideScenes_;   // <-- correct type
-    HttpClient httpClient_;
+    bool isWebSocketUrl() const;
+
+    // WebSocket implementation: one long-lived connection, reconnecting
+    // with backoff
+    void wsThread();
+    bool waitForRetry(std::chrono::milliseconds delay);
+    void publishOffline();
+
+    // Shared by both transports, the payload format is identical
+    BitrateInfo parseReceiverStats(std::string_view json);
+
+    bool webSocket_ = false;
+    std::unique_ptr<WsClient> ws_; // interrupted from the destructor
+    std::thread wsThread_;
+    std::atomic<bool> running_{false};
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
 };
 
 } // namespace BitrateSwitch
@@ -9,12 +9,10 @@ public:
     explicit XiuServer(const StreamServerConfig &config);
     ~XiuServer() override = default;
 
-    SwitchType checkSwitch(const Triggers &triggers) override;
-    BitrateInfo getBitrate() override;
-    std::string getSourceInfo() override;
-
-private:
-    BitrateInfo fetchStats();
+    std::vector<HttpRequest> statsRequests() override;
+    BitrateInfo parseStats(const std::vector<HttpResponse> &responses) override;
+    std::string describe(const BitrateInfo &info) override;
+    std::string getSourceInfo(const BitrateInfo &info) override;
 };
 
 } // namespace BitrateSwitch
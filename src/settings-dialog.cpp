@@ -445,6 +445,11 @@ void SettingsDialog::addServerEntry(const StreamServerConfig *initial)
     sp.urlEdit       = page->findChild<QLineEdit *>("srv_url");
     sp.keyEdit       = page->findChild<QLineEdit *>("srv_key");
     sp.prioritySpin  = page->findChild<QSpinBox *>("srv_priority");
+    sp.dependsCheck  = page->findChild<QCheckBox *>("srv_depends_enabled");
+    sp.dependsEdit   = page->findChild<QLineEdit *>("srv_depends_server");
+    sp.backupNormalCombo  = page->findChild<QComboBox *>("srv_backup_normal");
+    sp.backupLowCombo     = page->findChild<QComboBox *>("srv_backup_low");
+    sp.backupOfflineCombo = page->findChild<QComboBox *>("srv_backup_offline");
 
     QString label = initial ? QString::fromStdString(initial->name) : "New Server";
     sp.treeItem = new QTreeWidgetItem(serversParent_, {label});
@@ -650,6 +655,8 @@ QWidget *SettingsDialog::createServerPage(const StreamServerConfig *initial)
     QLineEdit *key = new QLineEdit(page);
     key->setObjectName("srv_key");
     key->setPlaceholderText("e.g. publish/live/feed1");
+    key->setToolTip("SLS, BELABOX and IRLHosting accept several publishers separated by commas; "
+                    "earlier ones are preferred while they are online");
     if (initial) key->setText(QString::fromStdString(initial->key));
 
     QSpinBox *priority = new QSpinBox(page);
@@ -666,6 +673,43 @@ QWidget *SettingsDialog::createServerPage(const StreamServerConfig *initial)
     form->addRow("Priority:", priority);
 
     layout->addWidget(group);
+
+    QGroupBox *backupGroup = new QGroupBox("Backup Server", page);
+    QFormLayout *backupForm = new QFormLayout(backupGroup);
+    backupForm->setFieldGrowthPolicy(QFormLayout::ExpandingFieldsGrow);
+
+    QCheckBox *dependsEnabled = new QCheckBox("Only use while another server is offline", page);
+    dependsEnabled->setObjectName("srv_depends_enabled");
+    dependsEnabled->setChecked(initial && initial->dependsOn.enabled);
+
+    QLineEdit *dependsServer = new QLineEdit(page);
+    dependsServer->setObjectName("srv_depends_server");
+    dependsServer->setPlaceholderText("Name of the primary server");
+    if (initial) dependsServer->setText(QString::fromStdString(initial->dependsOn.serverName));
+
+    backupForm->addRow(dependsEnabled);
+    backupForm->addRow("Primary Server:", dependsServer);
+
+    // (None) keeps the regular scene for that state
+    const char *backupNames[] = {"srv_backup_normal", "srv_backup_low", "srv_backup_offline"};
+    const char *backupLabels[] = {"Backup Normal Scene:", "Backup Low Scene:", "Backup Offline Scene:"};
+    const std::string *backupValues[] = {
+        initial ? &initial->dependsOn.backupScenes.normal : nullptr,
+        initial ? &initial->dependsOn.backupScenes.low : nullptr,
+        initial ? &initial->dependsOn.backupScenes.offline : nullptr,
+    };
+    for (int i = 0; i < 3; i++) {
+        QComboBox *combo = new QComboBox(page);
+        combo->setObjectName(backupNames[i]);
+        populateSceneComboBox(combo, true);
+        if (backupValues[i]) {
+            int idx = combo->findData(QString::fromStdString(*backupValues[i]));
+            if (idx >= 0) combo->setCurrentIndex(idx);
+        }
+        backupForm->addRow(backupLabels[i], combo);
+    }
+
+    layout->addWidget(backupGroup);
     layout->addStretch();
     return page;
 }
@@ -949,6 +993,53 @@ QWidget *SettingsDialog::createAdvancedPage()
     ristForm->addRow(ristHint);
     layout->addWidget(ristGrp);
 
+    QGroupBox *pollGrp = new QGroupBox("Polling", page);
+    QFormLayout *pollForm = new QFormLayout(pollGrp);
+    pollForm->setFieldGrowthPolicy(QFormLayout::ExpandingFieldsGrow);
+    staleSampleSpinBox_ = new QSpinBox(page);
+    staleSampleSpinBox_->setRange(1000, 60000);
+    staleSampleSpinBox_->setSingleStep(500);
+    staleSampleSpinBox_->setSuffix(" ms");
+    staleSampleSpinBox_->setToolTip("Treat a server as offline when its last stats reading is older than this");
+    pollForm->addRow("Stale Sample Age:", staleSampleSpinBox_);
+    compressStatsCheckbox_ = new QCheckBox("Request compressed stats (gzip / br / zstd)", page);
+    compressStatsCheckbox_->setToolTip("Saves bandwidth on metered or cellular links");
+    pollForm->addRow(compressStatsCheckbox_);
+    revalidateStatsCheckbox_ = new QCheckBox("Skip unchanged stats (ETag / Last-Modified)", page);
+    revalidateStatsCheckbox_->setToolTip("Servers that answer 304 Not Modified keep their last reading");
+    pollForm->addRow(revalidateStatsCheckbox_);
+    adaptiveTimeoutsCheckbox_ = new QCheckBox("Adaptive request timeouts", page);
+    adaptiveTimeoutsCheckbox_->setToolTip("Each server's timeout follows its own response times (4x p99), "
+                                          "so a hung server is noticed in milliseconds instead of seconds");
+    pollForm->addRow(adaptiveTimeoutsCheckbox_);
+    timeoutMinSpinBox_ = new QSpinBox(page);
+    timeoutMinSpinBox_->setRange(10, 5000);
+    timeoutMinSpinBox_->setSingleStep(10);
+    timeoutMinSpinBox_->setSuffix(" ms");
+    timeoutMinSpinBox_->setToolTip("Adaptive timeouts never go below this");
+    pollForm->addRow("Min Timeout:", timeoutMinSpinBox_);
+    timeoutMaxSpinBox_ = new QSpinBox(page);
+    timeoutMaxSpinBox_->setRange(100, 30000);
+    timeoutMaxSpinBox_->setSingleStep(500);
+    timeoutMaxSpinBox_->setSuffix(" ms");
+    timeoutMaxSpinBox_->setToolTip("Request timeout when adaptive is off, and the adaptive upper bound");
+    pollForm->addRow("Max Timeout:", timeoutMaxSpinBox_);
+    hedgePrimaryCheckbox_ = new QCheckBox("Hedge slow primary-server requests", page);
+    hedgePrimaryCheckbox_->setToolTip("When the top-priority server is slower than its usual p95, "
+                                      "ask again on a second connection and use whichever answers first");
+    pollForm->addRow(hedgePrimaryCheckbox_);
+    adaptiveCadenceCheckbox_ = new QCheckBox("Adaptive polling rate", page);
+    adaptiveCadenceCheckbox_->setToolTip("Poll several times a second while bitrate or RTT is near a trigger, "
+                                         "and every few seconds once the link has settled");
+    pollForm->addRow(adaptiveCadenceCheckbox_);
+    cadenceMarginSpinBox_ = new QSpinBox(page);
+    cadenceMarginSpinBox_->setRange(5, 100);
+    cadenceMarginSpinBox_->setSuffix(" %");
+    cadenceMarginSpinBox_->setToolTip("How close to a trigger, or how sharp a drop between polls, "
+                                      "switches to fast polling");
+    pollForm->addRow("Fast Polling Margin:", cadenceMarginSpinBox_);
+    layout->addWidget(pollGrp);
+
     layout->addStretch();
     return page;
 }
@@ -987,6 +1078,15 @@ void SettingsDialog::loadSettings()
     switchToStartingCheckbox_->setChecked(config_->options.switchToStartingOnStreamStart);
     switchFromStartingCheckbox_->setChecked(config_->options.switchFromStartingToLive);
     ristStaleFrameFixSpinBox_->setValue(config_->options.ristStaleFrameFixSec);
+    staleSampleSpinBox_->setValue(config_->options.staleSampleMs);
+    compressStatsCheckbox_->setChecked(config_->options.compressStats);
+    revalidateStatsCheckbox_->setChecked(config_->options.revalidateStats);
+    adaptiveTimeoutsCheckbox_->setChecked(config_->options.adaptiveTimeouts);
+    timeoutMinSpinBox_->setValue(config_->options.timeoutMinMs);
+    timeoutMaxSpinBox_->setValue(config_->options.timeoutMaxMs);
+    hedgePrimaryCheckbox_->setChecked(config_->options.hedgePrimary);
+    adaptiveCadenceCheckbox_->setChecked(config_->options.adaptiveCadence);
+    cadenceMarginSpinBox_->setValue(config_->options.cadenceMarginPercent);
 
     // Servers — create a page for each
     for (const auto &srv : config_->servers)
@@ -1081,6 +1181,15 @@ void SettingsDialog::saveSettings()
     config_->options.switchToStartingOnStreamStart = switchToStartingCheckbox_->isChecked();
     config_->options.switchFromStartingToLive = switchFromStartingCheckbox_->isChecked();
     config_->options.ristStaleFrameFixSec = ristStaleFrameFixSpinBox_->value();
+    config_->options.staleSampleMs = staleSampleSpinBox_->value();
+    config_->options.compressStats = compressStatsCheckbox_->isChecked();
+    config_->options.revalidateStats = revalidateStatsCheckbox_->isChecked();
+    config_->options.adaptiveTimeouts = adaptiveTimeoutsCheckbox_->isChecked();
+    config_->options.timeoutMinMs = timeoutMinSpinBox_->value();
+    config_->options.timeoutMaxMs = qMax(timeoutMaxSpinBox_->value(), timeoutMinSpinBox_->value());
+    config_->options.hedgePrimary = hedgePrimaryCheckbox_->isChecked();
+    config_->options.adaptiveCadence = adaptiveCadenceCheckbox_->isChecked();
+    config_->options.cadenceMarginPercent = cadenceMarginSpinBox_->value();
 
     // Servers from sidebar pages
     config_->servers.clear();
@@ -1094,6 +1203,14 @@ void SettingsDialog::saveSettings()
         srv.statsUrl = sp.urlEdit ? sp.urlEdit->text().toStdString() : "";
         srv.key = sp.keyEdit ? sp.keyEdit->text().toStdString() : "";
         srv.priority = sp.prioritySpin ? sp.prioritySpin->value() : 0;
+        srv.dependsOn.enabled = sp.dependsCheck && sp.dependsCheck->isChecked();
+        srv.dependsOn.serverName = sp.dependsEdit ? sp.dependsEdit->text().trimmed().toStdString() : "";
+        auto backupScene = [](QComboBox *combo) {
+            return combo ? combo->currentData().toString().toStdString() : std::string();
+        };
+        srv.dependsOn.backupScenes.normal = backupScene(sp.backupNormalCombo);
+        srv.dependsOn.backupScenes.low = backupScene(sp.backupLowCombo);
+        srv.dependsOn.backupScenes.offline = backupScene(sp.backupOfflineCombo);
         config_->servers.push_back(srv);
     }
     config_->sortServersByPriority();
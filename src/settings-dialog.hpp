@@ -26,6 +26,11 @@ struct ServerPage {
     QLineEdit *urlEdit = nullptr;
     QLineEdit *keyEdit = nullptr;
     QSpinBox *prioritySpin = nullptr;
+    QCheckBox *dependsCheck = nullptr;
+    QLineEdit *dependsEdit = nullptr;
+    QComboBox *backupNormalCombo = nullptr;
+    QComboBox *backupLowCombo = nullptr;
+    QComboBox *backupOfflineCombo = nullptr;
     QTreeWidgetItem *treeItem = nullptr;
     int stackIndex = -1;
 };
@@ -102,6 +107,15 @@ private:
     QCheckBox *switchToStartingCheckbox_;
     QCheckBox *switchFromStartingCheckbox_;
     QSpinBox *ristStaleFrameFixSpinBox_;
+    QSpinBox *staleSampleSpinBox_;
+    QCheckBox *compressStatsCheckbox_;
+    QCheckBox *revalidateStatsCheckbox_;
+    QCheckBox *adaptiveTimeoutsCheckbox_;
+    QSpinBox *timeoutMinSpinBox_;
+    QSpinBox *timeoutMaxSpinBox_;
+    QCheckBox *hedgePrimaryCheckbox_;
+    QCheckBox *adaptiveCadenceCheckbox_;
+    QSpinBox *cadenceMarginSpinBox_;
 
     // Status
     QLabel *statusLabel_;
@@ -1,5 +1,5 @@
 #include "stream-server.hpp"
-#include "switcher.hpp"
+#include "server-reload.hpp"
 #include "servers/belabox.hpp"
 #include "servers/nginx.hpp"
 #include "servers/sls.hpp"
@@ -11,9 +11,126 @@
 #include "servers/irlhosting.hpp"
 #include "servers/xiu.hpp"
 #include <obs-module.h>
+#include <algorithm>
+#include <cmath>
 
 namespace BitrateSwitch {
 
+SwitchType StreamServer::evaluate(const BitrateInfo &info, const Triggers &triggers)
+{
+    return evaluateTriggers(info, triggers);
+}
+
+std::string StreamServer::describe(const BitrateInfo &info)
+{
+    if (info.bitrateKbps <= 0)
+        return "";
+    return std::to_string(info.bitrateKbps) + " kbps, " +
+           std::to_string(static_cast<int>(std::round(info.rttMs))) + " ms";
+}
+
+ServerSample StreamServer::sample(const BitrateInfo &info, const Triggers &triggers)
+{
+    ServerSample result;
+    result.info = info;
+    result.type = evaluate(result.info, triggers);
+    result.info.message = describe(result.info);
+    result.info.serverName = name_;
+    return result;
+}
+
+ServerSample StreamServer::sample(const std::vector<HttpResponse> &responses,
+                                  const Triggers &triggers)
+{
+    return sample(parseStats(responses), triggers);
+}
+
+ServerSample StreamServer::sample(const Triggers &triggers)
+{
+    std::vector<HttpRequest> requests = statsRequests();
+    std::vector<HttpResponse> responses;
+    responses.reserve(requests.size());
+    for (const auto &request : requests)
+        responses.push_back(httpClient_.perform(request));
+    return sample(responses, triggers);
+}
+
+std::vector<HttpRequest> StreamServer::pollRequests(const FetchOptions &options)
+{
+    std::vector<HttpRequest> requests = statsRequests();
+    validators_.resize(requests.size());
+
+    int timeoutMs = options.adaptiveTimeout
+        ? latency_.timeoutMs(options.timeoutMinMs, options.timeoutMaxMs)
+        : options.timeoutMaxMs;
+
+    int hedgeAfterMs = 0;
+    if (options.hedge && latency_.count() >= LatencyTracker::kMinSamples)
+        hedgeAfterMs = (std::max)(1, static_cast<int>(std::ceil(latency_.percentile(0.95))));
+
+    for (size_t i = 0; i < requests.size(); i++) {
+        requests[i].timeoutMs = timeoutMs;
+        requests[i].hedgeAfterMs = hedgeAfterMs;
+        requests[i].compressed = options.compress;
+        if (options.revalidate && haveLastParsed_) {
+            requests[i].ifNoneMatch = validators_[i].etag;
+            requests[i].ifModifiedSince = validators_[i].lastModified;
+        }
+    }
+    return requests;
+}
+
+BitrateInfo StreamServer::pollResult(std::vector<HttpResponse> &responses)
+{
+    validators_.resize(responses.size());
+    bool keepBodies = responses.size() > 1;
+    // no requests at all (push or shared data) always needs a parse
+    bool changed = !haveLastParsed_ || responses.empty();
+
+    for (size_t i = 0; i < responses.size(); i++) {
+        HttpResponse &response = responses[i];
+        Validator &validator = validators_[i];
+
+        // A timeout counts at its full length so a server that slowed
+        // down widens its own timeout instead of timing out forever
+        if (response.success || response.notModified || response.timedOut)
+            latency_.record(response.elapsedMs);
+
+        if (response.notModified) {
+            if (keepBodies) {
+                response.body = validator.body;
+                response.sharedBody.reset();
+                response.success = true;
+            }
+            continue;
+        }
+
+        changed = true;
+        if (response.success) {
+            validator.etag = response.etag;
+            validator.lastModified = response.lastModified;
+            validator.body = keepBodies ? std::string(response.text()) : std::string();
+        } else {
+            validator = Validator();
+        }
+    }
+
+    if (!changed)
+        return lastParsed_;
+
+    lastParsed_ = parseStats(responses);
+    haveLastParsed_ = true;
+    return lastParsed_;
+}
+
+void StreamServer::publish(const BitrateInfo &info)
+{
+    TimedBitrateInfo timed;
+    timed.info = info;
+    timed.takenAt = std::chrono::steady_clock::now();
+    latest_.publish(std::move(timed));
+}
+
 SwitchType StreamServer::evaluateTriggers(const BitrateInfo &info, const Triggers &triggers)
 {
     if (!info.isOnline || info.bitrateKbps == 0)
@@ -42,6 +159,13 @@ SwitchType StreamServer::evaluateTriggers(const BitrateInfo &info, const Trigger
 }
 
 std::unique_ptr<StreamServer> StreamServer::create(const StreamServerConfig &config)
+{
+    std::unique_ptr<StreamServer> server = createForType(config);
+    server->configHash_ = hashServerConfig(config);
+    return server;
+}
+
+std::unique_ptr<StreamServer> StreamServer::createForType(const StreamServerConfig &config)
 {
     switch (config.type) {
     case ServerType::Belabox:
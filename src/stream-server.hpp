@@ -2,12 +2,22 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <chrono>
+#include "circuit-breaker.hpp"
 #include "config.hpp"
 #include "http-client.hpp"
+#include "latency-tracker.hpp"
+#include "latest-slot.hpp"
 
 namespace BitrateSwitch {
 
-enum class SwitchType;
+enum class SwitchType {
+    Normal,
+    Low,
+    Offline,
+    Previous
+};
 
 struct BitrateInfo {
     int64_t bitrateKbps = 0;
@@ -19,22 +29,100 @@ struct BitrateInfo {
     bool isOnline = false;
     std::string message;
     std::string serverName;
+
+    // Multi-publisher servers: the key this reading is for, and the
+    // server's other publishers in priority order (from the same fetch)
+    std::string publisher;
+    std::vector<BitrateInfo> backups;
+};
+
+// One poll of one server: the parsed stats plus the decision derived from
+// them. Built once per tick and handed around read-only so nothing in the
+// tick has to hit the network a second time.
+struct ServerSample {
+    BitrateInfo info;
+    SwitchType type = SwitchType::Offline;
+};
+
+// What the sampler publishes for each server: raw stats and when they
+// were taken, so readers can tell a live reading from a stale one.
+struct TimedBitrateInfo {
+    BitrateInfo info;
+    std::chrono::steady_clock::time_point takenAt;
+};
+
+// Per-poll fetch behaviour chosen in the settings
+struct FetchOptions {
+    bool compress = false;
+    bool revalidate = false;
+    // Timeouts follow each server's own response times within this range;
+    // with adaptive off every request gets timeoutMaxMs
+    bool adaptiveTimeout = false;
+    int timeoutMinMs = 50;
+    int timeoutMaxMs = 5000;
+    // Hedge this server's requests at its p95 response time
+    bool hedge = false;
 };
 
 class StreamServer {
 public:
     virtual ~StreamServer() = default;
 
-    virtual SwitchType checkSwitch(const Triggers &triggers) = 0;
-    virtual BitrateInfo getBitrate() = 0;
-    virtual std::string getSourceInfo() { return getBitrate().message; }
+    // A stats sample is split in two so the poll engine can run the HTTP
+    // part of every server concurrently: statsRequests() says what to
+    // fetch, parseStats() gets the responses back in the same order.
+    virtual std::vector<HttpRequest> statsRequests() = 0;
+    virtual BitrateInfo parseStats(const std::vector<HttpResponse> &responses) = 0;
+
+    // Maps a parsed sample to a switch decision. Servers with special
+    // "just started" semantics (NGINX, NMS) override this.
+    virtual SwitchType evaluate(const BitrateInfo &info, const Triggers &triggers);
+    virtual std::string describe(const BitrateInfo &info);
+
+    // Builds a complete sample from parsed stats or from already fetched
+    // responses. The serial overload does its own fetch and is meant for
+    // one-off callers.
+    ServerSample sample(const BitrateInfo &info, const Triggers &triggers);
+    ServerSample sample(const std::vector<HttpResponse> &responses, const Triggers &triggers);
+    ServerSample sample(const Triggers &triggers);
+
+    // statsRequests()/parseStats() with compression, revalidation and
+    // timeouts on top. pollRequests() stamps the previous poll's validators
+    // onto the requests; pollResult() records response times and hands
+    // back the last parse untouched when the server answered 304 to all of
+    // them. Sampler thread only.
+    std::vector<HttpRequest> pollRequests(const FetchOptions &options);
+    BitrateInfo pollResult(std::vector<HttpResponse> &responses);
+
+    // Servers that publish() on their own as data is pushed to them; the
+    // sampler leaves these alone
+    virtual bool pushesStats() const { return false; }
+
+    // Health gate the sampler consults before polling this server
+    CircuitBreaker &breaker() { return breaker_; }
+    const CircuitBreaker &breaker() const { return breaker_; }
+    const LatencyTracker &latency() const { return latency_; }
+
+    // Latest stats published by the sampler thread; null until the first
+    // poll completes
+    void publish(const BitrateInfo &info);
+    std::shared_ptr<const TimedBitrateInfo> latest() const { return latest_.load(); }
+
+    // Human-readable form of a sample, formatted without refetching
+    virtual std::string getSourceInfo(const BitrateInfo &info) { return describe(info); }
 
     static std::unique_ptr<StreamServer> create(const StreamServerConfig &config);
+    static std::unique_ptr<StreamServer> createForType(const StreamServerConfig &config);
 
     // Server metadata
     std::string getName() const { return name_; }
     bool hasOverrideScenes() const { return overrideScenes_.enabled; }
     const OverrideScenes& getOverrideScenes() const { return overrideScenes_; }
+    void setOverrideScenes(const OverrideScenes &scenes) { overrideScenes_ = scenes; }
+    const DependsOn& getDependsOn() const { return dependsOn_; }
+    void setDependsOn(const DependsOn &dependsOn) { dependsOn_ = dependsOn; }
+    bool isBackup() const { return dependsOn_.enabled && !dependsOn_.serverName.empty(); }
+    uint64_t configHash() const { return configHash_; }
 
 protected:
     HttpClient httpClient_;
@@ -47,6 +135,22 @@ protected:
     std::string authUser_;
     std::string authPass_;
     OverrideScenes overrideScenes_;
+    DependsOn dependsOn_;
+    LatestSlot<TimedBitrateInfo> latest_;
+    uint64_t configHash_ = 0;
+    CircuitBreaker breaker_;
+    LatencyTracker latency_;
+
+    // Revalidation state per request index. Bodies are only kept for
+    // multi-request servers, where one 304 may come back next to a 200.
+    struct Validator {
+        std::string etag;
+        std::string lastModified;
+        std::string body;
+    };
+    std::vector<Validator> validators_;
+    BitrateInfo lastParsed_;
+    bool haveLastParsed_ = false;
 
     SwitchType evaluateTriggers(const BitrateInfo &info, const Triggers &triggers);
 };
@@ -1,7 +1,7 @@
 #include "switcher.hpp"
+#include "server-reload.hpp"
 #include <obs-module.h>
 #include <obs-frontend-api.h>
-#include <util/platform.h>
 #include <algorithm>
 #include <cstring>
 #include <thread>
@@ -11,15 +11,27 @@ namespace BitrateSwitch {
 
 std::atomic<bool> g_pluginAlive{true};
 
+namespace {
+
+// Decisions only read the samplers' latest values, so the switcher can
+// tick well above the poll rate without ever waiting on the network
+constexpr auto kTickPeriod = std::chrono::milliseconds(100);
+
+double toMs(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+} // anonymous namespace
+
 Switcher::Switcher(Config *config)
     : config_(config)
     , sameTypeStart_(std::chrono::steady_clock::now())
     , offlineStart_(std::chrono::steady_clock::now())
     , streamStartTime_(std::chrono::steady_clock::now())
-    , cachedStatusString_("Status: Not started")
-    , cachedBitrateString_("Bitrate: --")
 {
-    prevScene_ = config_->scenes.normal;
+    status_.publish(SwitcherStatus());
+    prevScene_ = config_->snapshot()->scenes.normal;
     reloadServers();
 }
 
@@ -31,15 +43,41 @@ Switcher::~Switcher()
 void Switcher::reloadServers()
 {
     std::lock_guard<std::mutex> lock(mutex_);
+    const ConfigPtr cfg = config_->snapshot();
+
+    // Diff against the running servers instead of rebuilding them all:
+    // a server whose name and polling config are unchanged is kept, so a
+    // scene-name edit doesn't wipe rate caches and pooled connections.
+    std::vector<std::shared_ptr<StreamServer>> previous = std::move(servers_);
     servers_.clear();
-    
-    for (const auto &serverConfig : config_->servers) {
-        if (serverConfig.enabled) {
+    size_t kept = 0;
+
+    std::vector<RunningServer> running;
+    running.reserve(previous.size());
+    for (const auto &server : previous)
+        running.push_back(RunningServer{server->getName(), server->configHash()});
+    std::vector<size_t> plan = planServerReload(running, cfg->servers);
+
+    for (size_t i = 0; i < cfg->servers.size(); i++) {
+        const StreamServerConfig &serverConfig = cfg->servers[i];
+        if (!serverConfig.enabled)
+            continue;
+
+        if (plan[i] != kNewServer) {
+            std::shared_ptr<StreamServer> &server = previous[plan[i]];
+            server->setOverrideScenes(serverConfig.overrideScenes);
+            servers_.push_back(std::move(server));
+            kept++;
+        } else {
             servers_.push_back(StreamServer::create(serverConfig));
         }
+        servers_.back()->setDependsOn(serverConfig.dependsOn);
     }
-    
-    blog(LOG_INFO, "[BitrateSceneSwitch] Loaded %zu servers", servers_.size());
+    sampler_.setServers(servers_);
+
+    size_t removed = previous.size() - kept;
+    blog(LOG_INFO, "[BitrateSceneSwitch] Loaded %zu servers (%zu kept, %zu new, %zu removed)",
+         servers_.size(), kept, servers_.size() - kept, removed);
 }
 
 void Switcher::start()
@@ -48,24 +86,32 @@ void Switcher::start()
         return;
 
     running_ = true;
+    sampler_.start();
     switcherThread_ = std::thread(&Switcher::switcherThread, this);
     blog(LOG_INFO, "[BitrateSceneSwitch] Switcher started");
 }
 
 void Switcher::stop()
 {
+    auto begin = std::chrono::steady_clock::now();
     g_pluginAlive = false;
     running_ = false;
+    wake();
     disconnectChat();
     if (switcherThread_.joinable())
         switcherThread_.join();
+    sampler_.stop();
     if (refreshThread_.joinable())
         refreshThread_.join();
-    blog(LOG_INFO, "[BitrateSceneSwitch] Switcher stopped");
+    auto tookMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    blog(LOG_INFO, "[BitrateSceneSwitch] Switcher stopped in %lld ms", static_cast<long long>(tookMs));
 }
 
 void Switcher::onStreamingStarted()
 {
+    const ConfigPtr cfg = config_->snapshot();
+
     isStreaming_ = true;
     manualOverride_ = false;
     sameTypeStart_ = std::chrono::steady_clock::now();
@@ -73,42 +119,43 @@ void Switcher::onStreamingStarted()
     streamStartTime_ = std::chrono::steady_clock::now();
     blog(LOG_INFO, "[BitrateSceneSwitch] Streaming started");
 
-    if (config_->options.switchToStartingOnStreamStart && 
-        !config_->optionalScenes.starting.empty()) {
-        switchToScene(config_->optionalScenes.starting);
+    if (cfg->options.switchToStartingOnStreamStart && 
+        !cfg->optionalScenes.starting.empty()) {
+        switchToScene(cfg->optionalScenes.starting);
         wasOnStartingScene_ = true;
     }
 
-    if (config_->options.recordWhileStreaming && !isRecording_) {
+    if (cfg->options.recordWhileStreaming && !isRecording_) {
         obs_frontend_recording_start();
     }
+    wake();
 }
 
 void Switcher::onStreamingStopped()
 {
+    const ConfigPtr cfg = config_->snapshot();
+
     isStreaming_ = false;
     wasOnStartingScene_ = false;
     blog(LOG_INFO, "[BitrateSceneSwitch] Streaming stopped");
 
-    if (config_->options.recordWhileStreaming && isRecording_) {
+    if (cfg->options.recordWhileStreaming && isRecording_) {
         obs_frontend_recording_stop();
     }
 
-    if (!config_->optionalScenes.ending.empty()) {
-        switchToScene(config_->optionalScenes.ending);
+    if (!cfg->optionalScenes.ending.empty()) {
+        switchToScene(cfg->optionalScenes.ending);
     }
 }
 
 void Switcher::onSceneChanged()
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
+    // UI thread: publish only, never wait on the switcher
     obs_source_t *sceneSource = obs_frontend_get_current_scene();
     if (sceneSource) {
         const char *name = obs_source_get_name(sceneSource);
-        if (name) {
-            currentScene_ = name;
-        }
+        if (name)
+            currentScene_.publish(name);
         obs_source_release(sceneSource);
     }
 }
@@ -129,154 +176,237 @@ void Switcher::switcherThread()
 {
     blog(LOG_INFO, "[BitrateSceneSwitch] Switcher thread running");
 
+    // Ticks start on fixed slots of the steady clock, so slow work
+    // doesn't stretch the period; slots that have already passed are
+    // skipped rather than run back to back. wake() runs an extra tick
+    // straight away and leaves the schedule alone.
+    auto slot = std::chrono::steady_clock::now() + kTickPeriod;
     while (running_) {
-        os_sleep_ms(1000);
-
+        bool woken = false;
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            woken = wakeCv_.wait_until(lock, slot, [this] { return wakeRequested_ || !running_; });
+            wakeRequested_ = false;
+        }
         if (!running_)
             break;
 
-        if (chatReconnectRequested_.exchange(false)) {
-            chatReconnectDelay_ = 0;
-            bool wantChat;
-            {
-                config_->lockRead();
-                wantChat = config_->chat.enabled;
-                config_->unlockRead();
-            }
-            if (wantChat)
-                connectChat();
-            else
-                disconnectChat();
-            chatNextReconnect_ = std::chrono::steady_clock::now() +
-                                 std::chrono::seconds(10);
+        auto start = std::chrono::steady_clock::now();
+        if (!woken)
+            tickJitter_.record(toMs(start - slot));
+
+        tick();
+        ticks_++;
+
+        if (woken)
             continue;
-        }
 
-        bool chatConnected = false;
-        {
-            std::lock_guard<std::mutex> clock(chatMutex_);
-            if (kickChat_)
-                chatConnected = kickChat_->isConnected();
-            else if (twitchChat_)
-                chatConnected = twitchChat_->isConnected();
-
-            if (twitchPubSub_ && twitchPubSub_->isConnected()) {
-                pubsubWasConnected_ = true;
-                pubsubRetryDelay_ = 0;
-            } else if (twitchPubSub_ && !twitchPubSub_->isConnected() &&
-                       pubsubWasConnected_) {
-                auto now = std::chrono::steady_clock::now();
-                if (now >= pubsubNextRetry_) {
-                    blog(LOG_INFO,
-                         "[BitrateSceneSwitch] PubSub dropped, reconnecting (next retry %ds)...",
-                         pubsubRetryDelay_);
-                    twitchPubSub_->stop();
-                    twitchPubSub_->start();
-                    pubsubWasConnected_ = false;
-                    if (pubsubRetryDelay_ == 0)
-                        pubsubRetryDelay_ = 5;
-                    else if (pubsubRetryDelay_ < 60)
-                        pubsubRetryDelay_ = (std::min)(pubsubRetryDelay_ * 2, 60);
-                    pubsubNextRetry_ = now + std::chrono::seconds(pubsubRetryDelay_);
-                }
-            }
+        auto end = std::chrono::steady_clock::now();
+        auto overrun = end - (slot + kTickPeriod);
+        slot += kTickPeriod;
+        if (overrun > std::chrono::steady_clock::duration::zero()) {
+            tickOverrun_.record(toMs(overrun));
+            auto missed = overrun / kTickPeriod + 1;
+            ticksMissed_ += static_cast<uint64_t>(missed);
+            slot += missed * kTickPeriod;
         }
+    }
+}
 
-        if (config_->chat.enabled && !chatConnected) {
-            bool hasCreds = false;
-            {
-                config_->lockRead();
-                if (config_->chat.platform == ChatPlatform::Kick) {
-                    hasCreds = !config_->chat.channel.empty() &&
-                               config_->chat.kickChannelId != 0 &&
-                               config_->chat.kickChatroomId != 0;
-                } else {
-                    hasCreds = !config_->chat.channel.empty() &&
-                               !config_->chat.oauthToken.empty();
-                }
-                config_->unlockRead();
-            }
-            if (hasCreds) {
-                auto now = std::chrono::steady_clock::now();
-                if (now >= chatNextReconnect_) {
-                    blog(LOG_INFO, "[BitrateSceneSwitch] Chat dropped, retrying in %ds...",
-                         chatReconnectDelay_);
-                    connectChat();
-                    if (chatReconnectDelay_ == 0)
-                        chatReconnectDelay_ = 5;
-                    else if (chatReconnectDelay_ < 60)
-                        chatReconnectDelay_ = (std::min)(chatReconnectDelay_ * 2, 60);
-                    chatNextReconnect_ = now + std::chrono::seconds(chatReconnectDelay_);
-                }
-            }
-        } else if (config_->chat.enabled && chatConnected) {
-            chatReconnectDelay_ = 0;
-        }
+void Switcher::wake()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        wakeRequested_ = true;
+    }
+    // the refresh thread waits here too
+    wakeCv_.notify_all();
+}
+
+TickStats Switcher::tickStats() const
+{
+    TickStats stats;
+    stats.ticks = ticks_.load();
+    stats.missed = ticksMissed_.load();
+    stats.jitter = tickJitter_.counts();
+    stats.overrun = tickOverrun_.counts();
+    return stats;
+}
 
-        config_->lockRead();
+void Switcher::tick()
+{
+    // one config snapshot per tick; edits land on the next tick
+    const ConfigPtr cfg = config_->snapshot();
 
-        if (!config_->enabled) {
-            config_->unlockRead();
-            continue;
+    if (chatReconnectRequested_.exchange(false)) {
+        chatReconnectDelay_ = 0;
+        if (cfg->chat.enabled)
+            connectChat();
+        else
+            disconnectChat();
+        chatNextReconnect_ = std::chrono::steady_clock::now() +
+                             std::chrono::seconds(10);
+        return;
+    }
+
+    bool chatConnected = false;
+    bool chatConnecting = false;
+    {
+        std::lock_guard<std::mutex> clock(chatMutex_);
+        if (kickChat_) {
+            chatConnected = kickChat_->isConnected();
+            chatConnecting = kickChat_->isConnecting();
+        } else if (twitchChat_) {
+            chatConnected = twitchChat_->isConnected();
+            chatConnecting = twitchChat_->isConnecting();
         }
 
-        bool polledOffline;
-        {
-            StreamServer* dummy = nullptr;
-            polledOffline = (getOnlineServerStatusLocked(&dummy) == SwitchType::Offline);
+        if (twitchPubSub_ && twitchPubSub_->isConnected()) {
+            pubsubWasConnected_ = true;
+            pubsubRetryDelay_ = 0;
+        } else if (twitchPubSub_ && !twitchPubSub_->isConnected() &&
+                   pubsubWasConnected_) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= pubsubNextRetry_) {
+                blog(LOG_INFO,
+                     "[BitrateSceneSwitch] PubSub dropped, reconnecting (next retry %ds)...",
+                     pubsubRetryDelay_);
+                twitchPubSub_->stop();
+                twitchPubSub_->start();
+                pubsubWasConnected_ = false;
+                if (pubsubRetryDelay_ == 0)
+                    pubsubRetryDelay_ = 5;
+                else if (pubsubRetryDelay_ < 60)
+                    pubsubRetryDelay_ = (std::min)(pubsubRetryDelay_ * 2, 60);
+                pubsubNextRetry_ = now + std::chrono::seconds(pubsubRetryDelay_);
+            }
         }
+    }
 
-        if (config_->onlyWhenStreaming && !isStreaming_) {
-            config_->unlockRead();
-            continue;
+    // an attempt in progress is bounded by its own timeouts; let it finish
+    if (cfg->chat.enabled && !chatConnected && !chatConnecting) {
+        bool hasCreds = false;
+        if (cfg->chat.platform == ChatPlatform::Kick) {
+            hasCreds = !cfg->chat.channel.empty() &&
+                       cfg->chat.kickChannelId != 0 &&
+                       cfg->chat.kickChatroomId != 0;
+        } else {
+            hasCreds = !cfg->chat.channel.empty() &&
+                       !cfg->chat.oauthToken.empty();
         }
+        if (hasCreds) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= chatNextReconnect_) {
+                blog(LOG_INFO, "[BitrateSceneSwitch] Chat dropped, retrying in %ds...",
+                     chatReconnectDelay_);
+                connectChat();
+                if (chatReconnectDelay_ == 0)
+                    chatReconnectDelay_ = 5;
+                else if (chatReconnectDelay_ < 60)
+                    chatReconnectDelay_ = (std::min)(chatReconnectDelay_ * 2, 60);
+                chatNextReconnect_ = now + std::chrono::seconds(chatReconnectDelay_);
+            }
+        }
+    } else if (cfg->chat.enabled && chatConnected) {
+        chatReconnectDelay_ = 0;
+    }
 
-        handleRistStaleFrameFix(polledOffline);
+    sampler_.setEnabled(cfg->enabled);
+    FetchOptions fetchOptions;
+    fetchOptions.compress = cfg->options.compressStats;
+    fetchOptions.revalidate = cfg->options.revalidateStats;
+    fetchOptions.adaptiveTimeout = cfg->options.adaptiveTimeouts;
+    fetchOptions.timeoutMinMs = static_cast<int>(cfg->options.timeoutMinMs);
+    fetchOptions.timeoutMaxMs = static_cast<int>(cfg->options.timeoutMaxMs);
+    fetchOptions.hedge = cfg->options.hedgePrimary;
+    sampler_.setFetchOptions(fetchOptions);
+    CadencePolicy cadence;
+    cadence.adaptive = cfg->options.adaptiveCadence;
+    cadence.marginPercent = cfg->options.cadenceMarginPercent;
+    cadence.triggers = cfg->triggers;
+    cadence.staleSampleMs = cfg->options.staleSampleMs;
+    sampler_.setCadence(cadence);
+    if (!cfg->enabled)
+        return;
 
-        if (manualOverride_) {
-            config_->unlockRead();
-            continue;
-        }
+    // one read per tick; everything below works off this sample
+    const ServerSample sample = readSamples(cfg);
 
-        std::string current = getCurrentScene();
-        if (!isSceneSwitchable(current)) {
-            config_->unlockRead();
-            continue;
-        }
+    if (cfg->onlyWhenStreaming && !isStreaming_)
+        return;
 
-        doSwitchCheck();
-        config_->unlockRead();
-    }
+    handleRistStaleFrameFix(sample.type == SwitchType::Offline, cfg);
+
+    if (manualOverride_)
+        return;
+
+    std::string current = getCurrentScene();
+    if (!isSceneSwitchable(current, cfg))
+        return;
+
+    doSwitchCheck(sample, cfg);
 }
 
-void Switcher::updateStatusCache()
+void Switcher::publishStatusLocked(SwitchType type, const ConfigPtr &cfg)
 {
     // Caller must hold mutex_
-    BitrateInfo info = lastBitrateInfo_;
-    
-    if (info.isOnline) {
-        cachedStatusString_ = "Status: " + formatTemplate(config_->messages.statusResponse);
-        cachedBitrateString_ = "Bitrate: " + std::to_string(info.bitrateKbps) + " kbps";
+    SwitcherStatus status;
+    status.version = ++statusVersion_;
+    status.configVersion = cfg->version;
+    status.info = lastBitrateInfo_;
+    status.switchType = type;
+    status.prevScene = prevScene_;
+    status.serverCount = servers_.size();
+
+    auto now = std::chrono::steady_clock::now();
+    for (const auto &server : servers_) {
+        CircuitBreaker::Snapshot snap = server->breaker().snapshot(now);
+        ServerHealth health;
+        health.name = server->getName();
+        health.breaker = snap.state;
+        health.failures = snap.failures;
+        health.retryInMs = snap.retryInMs;
+        health.p50Ms = server->latency().percentile(0.5);
+        health.p99Ms = server->latency().percentile(0.99);
+        status.servers.push_back(health);
+
+        if (snap.state == CircuitBreaker::State::Closed)
+            continue;
+        if (!status.healthLine.empty())
+            status.healthLine += ", ";
+        status.healthLine += health.name + ": " + CircuitBreaker::stateName(snap.state);
+        if (snap.state == CircuitBreaker::State::Open)
+            status.healthLine += ", retry in " + std::to_string((snap.retryInMs + 999) / 1000) + " s";
+    }
+
+    if (status.info.isOnline) {
+        status.statusLine = "Status: " + formatTemplate(cfg->messages.statusResponse, status, "");
+        status.bitrateLine = "Bitrate: " + std::to_string(status.info.bitrateKbps) + " kbps";
     } else {
-        cachedStatusString_ = "Status: " + formatTemplate(config_->messages.statusOffline);
-        cachedBitrateString_ = "Bitrate: Offline";
+        status.statusLine = "Status: " + formatTemplate(cfg->messages.statusOffline, status, "");
+        status.bitrateLine = "Bitrate: Offline";
     }
+
+    status_.publish(std::move(status));
 }
 
-void Switcher::doSwitchCheck()
+void Switcher::doSwitchCheck(const ServerSample &sample, const ConfigPtr &cfg)
 {
     std::lock_guard<std::mutex> lock(mutex_);
 
+    // servers_ may have been reloaded since the read; resolve by name
     StreamServer* activeServer = nullptr;
-    SwitchType currentSwitchType = getOnlineServerStatusLocked(&activeServer);
+    if (sample.type != SwitchType::Offline)
+        activeServer = findServerLocked(sample.info.serverName);
+    SwitchType currentSwitchType = sample.type;
 
-    if (wasOnStartingScene_ && config_->options.switchFromStartingToLive) {
+    if (wasOnStartingScene_ && cfg->options.switchFromStartingToLive) {
         if (currentSwitchType == SwitchType::Normal || currentSwitchType == SwitchType::Low) {
             wasOnStartingScene_ = false;
         }
     }
 
-    bool forceSwitch = config_->instantRecover &&
+    bool forceSwitch = cfg->instantRecover &&
                        prevSwitchType_ == SwitchType::Offline &&
                        currentSwitchType != SwitchType::Offline;
 
@@ -287,11 +417,17 @@ void Switcher::doSwitchCheck()
         }
     }
 
-    if (prevSwitchType_ == currentSwitchType) {
-        sameTypeCount_++;
-    } else {
+    // The primary dropped and its backup has the stream: go there now
+    // rather than after the confirmation window
+    if (activeServer && activeServer->isBackup() &&
+        activeServer->getDependsOn().serverName == lastUsedServerName_) {
+        blog(LOG_INFO, "[BitrateSceneSwitch] %s offline, switching to backup %s",
+             lastUsedServerName_.c_str(), activeServer->getName().c_str());
+        forceSwitch = true;
+    }
+
+    if (prevSwitchType_ != currentSwitchType) {
         prevSwitchType_ = currentSwitchType;
-        sameTypeCount_ = 0;
         sameTypeStart_ = std::chrono::steady_clock::now();
         
         if (currentSwitchType == SwitchType::Offline) {
@@ -299,38 +435,35 @@ void Switcher::doSwitchCheck()
         }
     }
 
-    if (sameTypeCount_ < config_->retryAttempts && !forceSwitch) {
-        updateStatusCache();
+    // Checks run several times per poll now, so "retry attempts" is a
+    // wall-clock window: one attempt per second, as with the old 1 s tick
+    auto confirmWindow = std::chrono::seconds(cfg->retryAttempts);
+    if (std::chrono::steady_clock::now() - sameTypeStart_ < confirmWindow && !forceSwitch) {
+        publishStatusLocked(prevSwitchType_, cfg);
         return;
     }
 
-    if (!config_->onlyWhenStreaming) {
+    if (!cfg->onlyWhenStreaming) {
         auto streamElapsed = std::chrono::steady_clock::now() - streamStartTime_;
-        auto gracePeriod = std::chrono::seconds(config_->retryAttempts + 5);
+        auto gracePeriod = std::chrono::seconds(cfg->retryAttempts + 5);
         if (streamElapsed <= gracePeriod) {
             sameTypeStart_ = std::chrono::steady_clock::now();
         }
     }
 
-    sameTypeCount_ = 0;
+    sameTypeStart_ = std::chrono::steady_clock::now();
 
-    handleOfflineTimeout();
+    handleOfflineTimeout(cfg);
 
     StreamServer* serverForScenes = activeServer;
-    if (currentSwitchType == SwitchType::Offline && !lastUsedServerName_.empty()) {
-        for (auto& server : servers_) {
-            if (server->getName() == lastUsedServerName_) {
-                serverForScenes = server.get();
-                break;
-            }
-        }
-    }
+    if (currentSwitchType == SwitchType::Offline && !lastUsedServerName_.empty())
+        serverForScenes = findServerLocked(lastUsedServerName_);
 
     std::string targetScene;
     if (currentSwitchType == SwitchType::Previous) {
         targetScene = prevScene_;
     } else {
-        targetScene = getSceneForType(currentSwitchType, serverForScenes);
+        targetScene = getSceneForType(currentSwitchType, serverForScenes, cfg);
     }
 
     if (currentSwitchType == SwitchType::Normal || 
@@ -343,25 +476,27 @@ void Switcher::doSwitchCheck()
     }
 
     std::string currentScene = getCurrentScene();
-    if (!config_->optionalScenes.starting.empty() &&
-        currentScene == config_->optionalScenes.starting &&
-        config_->options.switchFromStartingToLive &&
+    if (!cfg->optionalScenes.starting.empty() &&
+        currentScene == cfg->optionalScenes.starting &&
+        cfg->options.switchFromStartingToLive &&
         currentSwitchType == SwitchType::Offline) {
-        updateStatusCache();
+        publishStatusLocked(prevSwitchType_, cfg);
         return;
     }
 
     if (getCurrentScene() != targetScene) {
+        blog(LOG_INFO, "[BitrateSceneSwitch] Switching to %s (config v%llu)",
+             targetScene.c_str(), static_cast<unsigned long long>(cfg->version));
         switchToScene(targetScene);
         announceSceneChange(currentSwitchType);
     }
     
-    updateStatusCache();
+    publishStatusLocked(prevSwitchType_, cfg);
 }
 
-void Switcher::handleRistStaleFrameFix(bool offline)
+void Switcher::handleRistStaleFrameFix(bool offline, const ConfigPtr &cfg)
 {
-    if (config_->options.ristStaleFrameFixSec == 0)
+    if (cfg->options.ristStaleFrameFixSec == 0)
         return;
 
     if (offline) {
@@ -373,10 +508,10 @@ void Switcher::handleRistStaleFrameFix(bool offline)
             ristFixTriggerTime_ = std::chrono::steady_clock::now();
         } else {
             auto elapsed = std::chrono::steady_clock::now() - ristFixTriggerTime_;
-            auto delaySec = std::chrono::seconds(config_->options.ristStaleFrameFixSec);
+            auto delaySec = std::chrono::seconds(cfg->options.ristStaleFrameFixSec);
             if (elapsed >= delaySec) {
                 blog(LOG_INFO, "[BitrateSceneSwitch] RIST stale frame fix: refreshing media sources after %u sec offline",
-                     config_->options.ristStaleFrameFixSec);
+                     cfg->options.ristStaleFrameFixSec);
                 obs_queue_task(
                     OBS_TASK_UI,
                     [](void *) {
@@ -420,12 +555,12 @@ void Switcher::handleRistStaleFrameFix(bool offline)
     }
 }
 
-void Switcher::handleOfflineTimeout()
+void Switcher::handleOfflineTimeout(const ConfigPtr &cfg)
 {
     if (prevSwitchType_ != SwitchType::Offline)
         return;
     
-    if (config_->options.offlineTimeoutMinutes == 0)
+    if (cfg->options.offlineTimeoutMinutes == 0)
         return;
     
     if (!isStreaming_)
@@ -434,9 +569,9 @@ void Switcher::handleOfflineTimeout()
     auto elapsed = std::chrono::steady_clock::now() - offlineStart_;
     auto minutes = std::chrono::duration_cast<std::chrono::minutes>(elapsed).count();
     
-    if (minutes >= static_cast<long>(config_->options.offlineTimeoutMinutes)) {
+    if (minutes >= static_cast<long>(cfg->options.offlineTimeoutMinutes)) {
         blog(LOG_INFO, "[BitrateSceneSwitch] Offline timeout reached (%d min), stopping stream",
-             config_->options.offlineTimeoutMinutes);
+             cfg->options.offlineTimeoutMinutes);
         obs_queue_task(OBS_TASK_UI, [](void*) {
             obs_frontend_streaming_stop();
         }, nullptr, false);
@@ -445,34 +580,84 @@ void Switcher::handleOfflineTimeout()
 
 void Switcher::handleStartingScene()
 {
-    if (wasOnStartingScene_ && config_->options.switchFromStartingToLive) {
+    const ConfigPtr cfg = config_->snapshot();
+
+    if (wasOnStartingScene_ && cfg->options.switchFromStartingToLive) {
         wasOnStartingScene_ = false;
-        switchToScene(config_->scenes.normal);
+        switchToScene(cfg->scenes.normal);
     }
 }
 
-SwitchType Switcher::getOnlineServerStatus(StreamServer** activeServer)
+ServerSample Switcher::readSamples(const ConfigPtr &cfg)
 {
     std::lock_guard<std::mutex> lock(mutex_);
-    return getOnlineServerStatusLocked(activeServer);
+    return readSamplesLocked(cfg);
 }
 
-SwitchType Switcher::getOnlineServerStatusLocked(StreamServer** activeServer)
+ServerSample Switcher::readSamplesLocked(const ConfigPtr &cfg)
 {
-    for (auto &server : servers_) {
-        SwitchType status = server->checkSwitch(config_->triggers);
+    // Walk servers in priority order using whatever the sampler last
+    // published. A server with no reading, or only an old one, counts as
+    // offline so a hung stats endpoint can't pin the live scene.
+    auto now = std::chrono::steady_clock::now();
+    auto maxAge = std::chrono::milliseconds(cfg->options.staleSampleMs);
+
+    // Every server is read up front so a backup can see its primary's
+    // state no matter which of the two comes first in priority order
+    std::vector<ServerSample> samples(servers_.size());
+    for (size_t i = 0; i < servers_.size(); i++) {
+        StreamServer &server = *servers_[i];
+        std::shared_ptr<const TimedBitrateInfo> latest = server.latest();
+        if (!latest || now - latest->takenAt > maxAge)
+            continue;
+
+        ServerSample sample = server.sample(latest->info, cfg->triggers);
+
+        // Multi-publisher servers fail over between their own keys first;
+        // the backups came in with the same fetch
+        for (size_t j = 0; sample.type == SwitchType::Offline && j < latest->info.backups.size(); j++)
+            sample = server.sample(latest->info.backups[j], cfg->triggers);
+        samples[i] = std::move(sample);
+    }
+
+    for (size_t i = 0; i < servers_.size(); i++) {
+        ServerSample &sample = samples[i];
+
+        // A backup stays out of the way while its primary is carrying
+        // the stream; an unknown primary counts as offline
+        if (servers_[i]->isBackup()) {
+            const std::string &primary = servers_[i]->getDependsOn().serverName;
+            bool primaryOnline = false;
+            for (size_t j = 0; j < servers_.size(); j++) {
+                if (j != i && servers_[j]->getName() == primary)
+                    primaryOnline = samples[j].type != SwitchType::Offline;
+            }
+            if (primaryOnline)
+                continue;
+        }
 
-        if (status != SwitchType::Offline) {
-            lastBitrateInfo_ = server->getBitrate();
-            lastBitrateInfo_.serverName = server->getName();
-            if (activeServer) *activeServer = server.get();
-            return status;
+        if (sample.type != SwitchType::Offline) {
+            if (!sample.info.publisher.empty() && sample.info.publisher != lastBitrateInfo_.publisher)
+                blog(LOG_INFO, "[BitrateSceneSwitch] %s: reading publisher %s",
+                     sample.info.serverName.c_str(), sample.info.publisher.c_str());
+            lastBitrateInfo_ = sample.info;
+            publishStatusLocked(sample.type, cfg);
+            return sample;
         }
     }
 
     lastBitrateInfo_ = BitrateInfo();
-    if (activeServer) *activeServer = nullptr;
-    return SwitchType::Offline;
+    publishStatusLocked(SwitchType::Offline, cfg);
+    return ServerSample();
+}
+
+StreamServer* Switcher::findServerLocked(const std::string &name)
+{
+    for (auto &server : servers_) {
+        if (server->getName() == name)
+            return server.get();
+    }
+    return nullptr;
 }
 
 void Switcher::switchToScene(const std::string &sceneName)
@@ -495,8 +680,26 @@ void Switcher::switchToScene(const std::string &sceneName)
     }
 }
 
-std::string Switcher::getSceneForType(SwitchType type, StreamServer* server)
+std::string Switcher::getSceneForType(SwitchType type, StreamServer* server, const ConfigPtr &cfg)
 {
+    // A backup is only ever active while its primary is down
+    if (server && server->isBackup()) {
+        const SwitchingScenes &backup = server->getDependsOn().backupScenes;
+        switch (type) {
+        case SwitchType::Normal:
+            if (!backup.normal.empty()) return backup.normal;
+            break;
+        case SwitchType::Low:
+            if (!backup.low.empty()) return backup.low;
+            break;
+        case SwitchType::Offline:
+            if (!backup.offline.empty()) return backup.offline;
+            break;
+        default:
+            break;
+        }
+    }
+
     if (server && server->hasOverrideScenes()) {
         const OverrideScenes& override = server->getOverrideScenes();
         switch (type) {
@@ -516,26 +719,38 @@ std::string Switcher::getSceneForType(SwitchType type, StreamServer* server)
 
     switch (type) {
     case SwitchType::Normal:
-        return config_->scenes.normal;
+        return cfg->scenes.normal;
     case SwitchType::Low:
-        return config_->scenes.low;
+        return cfg->scenes.low;
     case SwitchType::Offline:
-        return config_->scenes.offline;
+        return cfg->scenes.offline;
     default:
-        return config_->scenes.normal;
+        return cfg->scenes.normal;
     }
 }
 
-bool Switcher::isSceneSwitchable(const std::string &scene)
+bool Switcher::isSceneSwitchable(const std::string &scene, const ConfigPtr &cfg)
 {
-    if (scene == config_->scenes.normal ||
-        scene == config_->scenes.low ||
-        scene == config_->scenes.offline) {
+    if (scene == cfg->scenes.normal ||
+        scene == cfg->scenes.low ||
+        scene == cfg->scenes.offline) {
         return true;
     }
+
+    // Per-server scenes are ours to switch away from too
+    for (const auto &server : cfg->servers) {
+        if (!server.enabled)
+            continue;
+        const OverrideScenes &ov = server.overrideScenes;
+        if (ov.enabled && (scene == ov.normal || scene == ov.low || scene == ov.offline))
+            return true;
+        const SwitchingScenes &bk = server.dependsOn.backupScenes;
+        if (server.dependsOn.enabled && (scene == bk.normal || scene == bk.low || scene == bk.offline))
+            return true;
+    }
     
-    if (wasOnStartingScene_ && scene == config_->optionalScenes.starting) {
-        return config_->options.switchFromStartingToLive;
+    if (wasOnStartingScene_ && scene == cfg->optionalScenes.starting) {
+        return cfg->options.switchFromStartingToLive;
     }
     
     return false;
@@ -559,22 +774,28 @@ std::string Switcher::getCurrentScene()
 
 void Switcher::switchToLive()
 {
-    switchToScene(config_->scenes.normal);
+    const ConfigPtr cfg = config_->snapshot();
+
+    switchToScene(cfg->scenes.normal);
     blog(LOG_INFO, "[BitrateSceneSwitch] Manual switch to Live scene");
 }
 
 void Switcher::switchToPrivacy()
 {
-    if (!config_->optionalScenes.privacy.empty()) {
-        switchToScene(config_->optionalScenes.privacy);
+    const ConfigPtr cfg = config_->snapshot();
+
+    if (!cfg->optionalScenes.privacy.empty()) {
+        switchToScene(cfg->optionalScenes.privacy);
         blog(LOG_INFO, "[BitrateSceneSwitch] Manual switch to Privacy scene");
     }
 }
 
 void Switcher::switchToStarting()
 {
-    if (!config_->optionalScenes.starting.empty()) {
-        switchToScene(config_->optionalScenes.starting);
+    const ConfigPtr cfg = config_->snapshot();
+
+    if (!cfg->optionalScenes.starting.empty()) {
+        switchToScene(cfg->optionalScenes.starting);
         wasOnStartingScene_ = true;
         blog(LOG_INFO, "[BitrateSceneSwitch] Manual switch to Starting scene");
     }
@@ -582,18 +803,22 @@ void Switcher::switchToStarting()
 
 void Switcher::switchToEnding()
 {
-    if (!config_->optionalScenes.ending.empty()) {
-        switchToScene(config_->optionalScenes.ending);
+    const ConfigPtr cfg = config_->snapshot();
+
+    if (!cfg->optionalScenes.ending.empty()) {
+        switchToScene(cfg->optionalScenes.ending);
         blog(LOG_INFO, "[BitrateSceneSwitch] Manual switch to Ending scene");
     }
 }
 
 void Switcher::refreshScene()
 {
-    if (!config_->optionalScenes.refresh.empty()) {
+    const ConfigPtr cfg = config_->snapshot();
+
+    if (!cfg->optionalScenes.refresh.empty()) {
         std::string previousScene = getCurrentScene();
 
-        if (previousScene == config_->optionalScenes.refresh) {
+        if (previousScene == cfg->optionalScenes.refresh) {
             blog(LOG_INFO, "[BitrateSceneSwitch] Refresh: already on refresh scene, skipping");
             return;
         }
@@ -603,7 +828,7 @@ void Switcher::refreshScene()
             return;
         }
 
-        switchToScene(config_->optionalScenes.refresh);
+        switchToScene(cfg->optionalScenes.refresh);
         blog(LOG_INFO, "[BitrateSceneSwitch] Refresh: switching to refresh scene");
 
         if (refreshThread_.joinable())
@@ -611,8 +836,10 @@ void Switcher::refreshScene()
 
         refreshing_ = true;
         refreshThread_ = std::thread([this, previousScene]() {
-            for (int i = 0; i < 50 && running_; ++i)
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex_);
+                wakeCv_.wait_for(lock, std::chrono::seconds(5), [this] { return !running_; });
+            }
             if (running_) {
                 switchToScene(previousScene);
                 blog(LOG_INFO, "[BitrateSceneSwitch] Refresh: returned to scene: %s",
@@ -668,19 +895,25 @@ void Switcher::fixMediaSources()
 
 void Switcher::switchToLow()
 {
-    switchToScene(config_->scenes.low);
+    const ConfigPtr cfg = config_->snapshot();
+
+    switchToScene(cfg->scenes.low);
     blog(LOG_INFO, "[BitrateSceneSwitch] Manual switch to Low scene");
 }
 
 void Switcher::switchToBrb()
 {
-    switchToScene(config_->scenes.offline);
+    const ConfigPtr cfg = config_->snapshot();
+
+    switchToScene(cfg->scenes.offline);
     blog(LOG_INFO, "[BitrateSceneSwitch] Manual switch to BRB/Offline scene");
 }
 
 void Switcher::triggerSwitch()
 {
-    doSwitchCheck();
+    const ConfigPtr cfg = config_->snapshot();
+
+    doSwitchCheck(readSamples(cfg), cfg);
     blog(LOG_INFO, "[BitrateSceneSwitch] Manual trigger of switch check");
 }
 
@@ -784,14 +1017,11 @@ void Switcher::connectChat()
     ChatConfig chatCfg;
     bool wantPubSub = false;
     {
-        config_->lockRead();
-        if (!config_->chat.enabled) {
-            config_->unlockRead();
+        const ConfigPtr cfg = config_->snapshot();
+        if (!cfg->chat.enabled)
             return;
-        }
-        chatCfg = config_->chat;
-        wantPubSub = config_->chat.autoStopStreamOnRaid;
-        config_->unlockRead();
+        chatCfg = cfg->chat;
+        wantPubSub = cfg->chat.autoStopStreamOnRaid;
     }
 
     std::lock_guard<std::mutex> lock(chatMutex_);
@@ -815,7 +1045,7 @@ void Switcher::connectChat()
             handleRaidStop(slug, disp);
         });
         if (kickChat_->connect())
-            blog(LOG_INFO, "[BitrateSceneSwitch] Chat connected (Kick)");
+            blog(LOG_INFO, "[BitrateSceneSwitch] Chat connecting (Kick)");
         return;
     }
 
@@ -824,6 +1054,9 @@ void Switcher::connectChat()
         handleChatCommand(msg);
     });
     twitchChat_->setConfig(chatCfg);
+    // connecting happens in the background; hear about the outcome on
+    // the next tick instead of a second later
+    twitchChat_->setStateCallback([this] { wake(); });
 
     if (wantPubSub) {
         twitchPubSub_ = std::make_unique<TwitchPubSubClient>();
@@ -843,7 +1076,7 @@ void Switcher::connectChat()
     }
 
     if (twitchChat_->connect())
-        blog(LOG_INFO, "[BitrateSceneSwitch] Chat connected (Twitch)");
+        blog(LOG_INFO, "[BitrateSceneSwitch] Chat connecting (Twitch)");
 }
 
 void Switcher::disconnectChat()
@@ -883,12 +1116,13 @@ void Switcher::handleRaidStop(const std::string &targetLogin, const std::string
     ChatPlatform plat = ChatPlatform::Twitch;
     std::string tmpl;
 
-    config_->lockRead();
-    autoStop = config_->chat.autoStopStreamOnRaid;
-    announce = config_->chat.announceRaidStop;
-    plat = config_->chat.platform;
-    tmpl = config_->messages.raidStop;
-    config_->unlockRead();
+    {
+        const ConfigPtr cfg = config_->snapshot();
+        autoStop = cfg->chat.autoStopStreamOnRaid;
+        announce = cfg->chat.announceRaidStop;
+        plat = cfg->chat.platform;
+        tmpl = cfg->messages.raidStop;
+    }
 
     blog(LOG_INFO,
          "[BitrateSceneSwitch] Raid event received: target=%s display=%s",
@@ -929,12 +1163,14 @@ void Switcher::handleRaidStop(const std::string &targetLogin, const std::string
 
 void Switcher::handleChatCommand(const ChatMessage& msg)
 {
+    const ConfigPtr cfg = config_->snapshot();
+
     blog(LOG_INFO, "[BitrateSceneSwitch] Chat command from %s: %s", 
          msg.username.c_str(), msg.message.c_str());
 
     auto reply = [this](const std::string &text) { sendChatMessage(text); };
-    auto announce = [this, &reply](const std::string &text) {
-        if (config_->chat.announceSceneChanges)
+    auto announce = [&cfg, &reply](const std::string &text) {
+        if (cfg->chat.announceSceneChanges)
             reply(text);
     };
 
@@ -942,37 +1178,37 @@ void Switcher::handleChatCommand(const ChatMessage& msg)
     case ChatCommand::Live:
         manualOverride_ = false;
         switchToLive();
-        announce(formatTemplate(config_->messages.sceneSwitched, config_->scenes.normal));
+        announce(formatTemplate(cfg->messages.sceneSwitched, cfg->scenes.normal));
         break;
     case ChatCommand::Low:
         manualOverride_ = true;
         switchToLow();
-        announce(formatTemplate(config_->messages.sceneSwitched, config_->scenes.low));
+        announce(formatTemplate(cfg->messages.sceneSwitched, cfg->scenes.low));
         break;
     case ChatCommand::Brb:
         manualOverride_ = true;
         switchToBrb();
-        announce(formatTemplate(config_->messages.sceneSwitched, config_->scenes.offline));
+        announce(formatTemplate(cfg->messages.sceneSwitched, cfg->scenes.offline));
         break;
     case ChatCommand::Privacy:
-        if (config_->optionalScenes.privacy.empty()) {
+        if (cfg->optionalScenes.privacy.empty()) {
             reply("No privacy scene configured");
         } else {
             manualOverride_ = true;
             switchToPrivacy();
-            announce(formatTemplate(config_->messages.sceneSwitched,
-                                    config_->optionalScenes.privacy));
+            announce(formatTemplate(cfg->messages.sceneSwitched,
+                                    cfg->optionalScenes.privacy));
         }
         break;
     case ChatCommand::Refresh:
         refreshScene();
-        announce(formatTemplate(config_->messages.refreshing));
+        announce(formatTemplate(cfg->messages.refreshing));
         break;
     case ChatCommand::Status:
-        if (lastBitrateInfo_.isOnline)
-            reply(formatTemplate(config_->messages.statusResponse));
+        if (getLastBitrateInfo().isOnline)
+            reply(formatTemplate(cfg->messages.statusResponse));
         else
-            reply(formatTemplate(config_->messages.statusOffline));
+            reply(formatTemplate(cfg->messages.statusOffline));
         break;
     case ChatCommand::Trigger:
         manualOverride_ = false;
@@ -981,14 +1217,14 @@ void Switcher::handleChatCommand(const ChatMessage& msg)
         break;
     case ChatCommand::Fix:
         fixMediaSources();
-        announce(formatTemplate(config_->messages.fixAttempt));
+        announce(formatTemplate(cfg->messages.fixAttempt));
         break;
     case ChatCommand::SwitchScene:
         if (msg.args.empty()) {
-            reply("Usage: " + config_->chat.cmdSwitchScene + " <scene_name>");
+            reply("Usage: " + cfg->chat.cmdSwitchScene + " <scene_name>");
         } else if (switchToSceneByName(msg.args)) {
             manualOverride_ = true;
-            announce(formatTemplate(config_->messages.sceneSwitched, msg.args));
+            announce(formatTemplate(cfg->messages.sceneSwitched, msg.args));
         } else {
             reply("Scene not found: " + msg.args);
         }
@@ -1000,7 +1236,7 @@ void Switcher::handleChatCommand(const ChatMessage& msg)
             obs_queue_task(OBS_TASK_UI, [](void*) {
                 obs_frontend_streaming_start();
             }, nullptr, false);
-            reply(formatTemplate(config_->messages.streamStarted));
+            reply(formatTemplate(cfg->messages.streamStarted));
             blog(LOG_INFO, "[BitrateSceneSwitch] Stream started via chat");
         }
         break;
@@ -1011,7 +1247,7 @@ void Switcher::handleChatCommand(const ChatMessage& msg)
             obs_queue_task(OBS_TASK_UI, [](void*) {
                 obs_frontend_streaming_stop();
             }, nullptr, false);
-            reply(formatTemplate(config_->messages.streamStopped));
+            reply(formatTemplate(cfg->messages.streamStopped));
             blog(LOG_INFO, "[BitrateSceneSwitch] Stream stopped via chat");
         }
         break;
@@ -1021,23 +1257,28 @@ void Switcher::handleChatCommand(const ChatMessage& msg)
     default:
         break;
     }
+
+    // act on a cleared override (or new state) now, not at the next slot
+    wake();
 }
 
 void Switcher::announceSceneChange(SwitchType type)
 {
-    if (!config_->chat.announceSceneChanges)
+    const ConfigPtr cfg = config_->snapshot();
+
+    if (!cfg->chat.announceSceneChanges)
         return;
 
     std::string tmpl;
     switch (type) {
     case SwitchType::Normal:
-        tmpl = config_->messages.switchedToLive;
+        tmpl = cfg->messages.switchedToLive;
         break;
     case SwitchType::Low:
-        tmpl = config_->messages.switchedToLow;
+        tmpl = cfg->messages.switchedToLow;
         break;
     case SwitchType::Offline:
-        tmpl = config_->messages.switchedToOffline;
+        tmpl = cfg->messages.switchedToOffline;
         break;
     default:
         return;
@@ -1047,6 +1288,12 @@ void Switcher::announceSceneChange(SwitchType type)
 }
 
 std::string Switcher::formatTemplate(const std::string &tmpl, const std::string &sceneOverride)
+{
+    return formatTemplate(tmpl, *getStatus(), sceneOverride);
+}
+
+std::string Switcher::formatTemplate(const std::string &tmpl, const SwitcherStatus &status,
+                                     const std::string &sceneOverride)
 {
     std::string result = tmpl;
     
@@ -1058,13 +1305,17 @@ std::string Switcher::formatTemplate(const std::string &tmpl, const std::string
         }
     };
     
-    BitrateInfo info = lastBitrateInfo_;
-    std::string scene = sceneOverride.empty() ? getCurrentScene() : sceneOverride;
+    const BitrateInfo &info = status.info;
+    std::string scene = sceneOverride;
+    if (scene.empty()) {
+        auto cached = currentScene_.load();
+        scene = cached ? *cached : getCurrentScene();
+    }
     
     replaceAll(result, "{bitrate}", std::to_string(info.bitrateKbps));
     replaceAll(result, "{rtt}", std::to_string(static_cast<int>(info.rttMs)));
     replaceAll(result, "{scene}", scene);
-    replaceAll(result, "{prev_scene}", prevScene_);
+    replaceAll(result, "{prev_scene}", status.prevScene);
     replaceAll(result, "{server}", info.serverName);
     replaceAll(result, "{status}", info.isOnline ? "Online" : "Offline");
     replaceAll(result, "{uptime}", isStreaming_ ? "Live" : "Not streaming");
@@ -1074,12 +1325,14 @@ std::string Switcher::formatTemplate(const std::string &tmpl, const std::string
 
 void Switcher::handleCustomCommands(const ChatMessage& msg)
 {
-    if (config_->customCommands.empty()) return;
+    const ConfigPtr cfg = config_->snapshot();
+
+    if (cfg->customCommands.empty()) return;
     
     std::string msgLower = msg.message;
     std::transform(msgLower.begin(), msgLower.end(), msgLower.begin(), ::tolower);
     
-    for (const auto &cmd : config_->customCommands) {
+    for (const auto &cmd : cfg->customCommands) {
         if (!cmd.enabled || cmd.trigger.empty()) continue;
         
         std::string triggerLower = cmd.trigger;
@@ -1092,48 +1345,51 @@ void Switcher::handleCustomCommands(const ChatMessage& msg)
     }
 }
 
+std::shared_ptr<const SwitcherStatus> Switcher::getStatus() const
+{
+    return status_.load();
+}
+
 BitrateInfo Switcher::getLastBitrateInfo() const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return lastBitrateInfo_;
+    return getStatus()->info;
 }
 
 BitrateInfo Switcher::getCurrentBitrate()
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return lastBitrateInfo_;
+    return getStatus()->info;
 }
 
 std::string Switcher::getStatusString()
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    if (!config_->enabled)
+    const ConfigPtr cfg = config_->snapshot();
+
+    if (!cfg->enabled)
         return "Disabled";
     
-    if (config_->onlyWhenStreaming && !isStreaming_)
+    if (cfg->onlyWhenStreaming && !isStreaming_)
         return "Waiting for stream";
     
-    if (servers_.empty())
+    std::shared_ptr<const SwitcherStatus> status = getStatus();
+    if (status->serverCount == 0)
         return "No servers configured";
     
-    if (lastBitrateInfo_.isOnline) {
-        return formatTemplate(config_->messages.statusResponse);
-    }
-    
-    return formatTemplate(config_->messages.statusOffline);
+    std::string result = status->info.isOnline
+        ? formatTemplate(cfg->messages.statusResponse, *status, "")
+        : formatTemplate(cfg->messages.statusOffline, *status, "");
+    if (!status->healthLine.empty())
+        result += " (" + status->healthLine + ")";
+    return result;
 }
 
 std::string Switcher::getCachedStatusLine()
 {
-    std::lock_guard<std::mutex> lock(statusCacheMutex_);
-    return cachedStatusString_;
+    return getStatus()->statusLine;
 }
 
 std::string Switcher::getCachedBitrateLine()
 {
-    std::lock_guard<std::mutex> lock(statusCacheMutex_);
-    return cachedBitrateString_;
+    return getStatus()->bitrateLine;
 }
 
 } // namespace BitrateSwitch
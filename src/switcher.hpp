@@ -1,6 +1,7 @@
 #pragma once
 
 #include <obs.h>
+#include <array>
 #include <atomic>
 #include <thread>
 #include <mutex>
@@ -8,9 +9,12 @@
 #include <memory>
 #include <string>
 #include <chrono>
+#include <condition_variable>
 
 #include "config.hpp"
+#include "histogram.hpp"
 #include "stream-server.hpp"
+#include "sampler.hpp"
 #include "chat-client.hpp"
 #include "kick-chat.hpp"
 #include "twitch-pubsub.hpp"
@@ -19,11 +23,40 @@ namespace BitrateSwitch {
 
 extern std::atomic<bool> g_pluginAlive;
 
-enum class SwitchType {
-    Normal,
-    Low,
-    Offline,
-    Previous
+// Circuit-breaker state and response times of one configured server
+struct ServerHealth {
+    std::string name;
+    CircuitBreaker::State breaker = CircuitBreaker::State::Closed;
+    uint32_t failures = 0;
+    int64_t retryInMs = 0;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+};
+
+// How closely the switcher thread keeps to its tick schedule. Jitter is
+// how late a scheduled tick started; overrun is how far a tick's work ran
+// past the start of the next slot.
+struct TickStats {
+    uint64_t ticks = 0;
+    uint64_t missed = 0;   // slots skipped because a tick overran them
+    std::array<uint64_t, Histogram::kBuckets> jitter{};
+    std::array<uint64_t, Histogram::kBuckets> overrun{};
+};
+
+// Read-only view of the switcher for the UI, chat and websocket. The
+// switcher thread publishes a new one after every read/decision; readers
+// load it without touching mutex_, so a slow tick can never stall them.
+struct SwitcherStatus {
+    uint64_t version = 0;
+    uint64_t configVersion = 0;   // config snapshot the last decision used
+    BitrateInfo info;
+    SwitchType switchType = SwitchType::Offline;
+    std::string prevScene;
+    size_t serverCount = 0;
+    std::string statusLine = "Status: Not started";
+    std::string bitrateLine = "Bitrate: --";
+    std::vector<ServerHealth> servers;
+    std::string healthLine;   // empty while every breaker is closed
 };
 
 class Switcher {
@@ -41,14 +74,14 @@ public:
     void onRecordingStarted();
     void onRecordingStopped();
 
+    // Lock-free snapshot accessors, safe from any thread
+    std::shared_ptr<const SwitcherStatus> getStatus() const;
     BitrateInfo getCurrentBitrate();
-    BitrateInfo getLastBitrateInfo() const;  
+    BitrateInfo getLastBitrateInfo() const;
     std::string getStatusString();
     std::string getCurrentScene();
     bool isCurrentlyStreaming() const { return isStreaming_; }
-    SwitchType getCurrentSwitchType() const { return prevSwitchType_; }
-    
-    // Fast cached accessors for UI timer (no network, no waiting on mutex_)
+    SwitchType getCurrentSwitchType() const { return getStatus()->switchType; }
     std::string getCachedStatusLine();
     std::string getCachedBitrateLine();
 
@@ -68,37 +101,53 @@ public:
     void connectChat();
     void disconnectChat();
     bool isChatConnected() const;
-    void requestChatReconnect() { chatReconnectRequested_ = true; }
+    void requestChatReconnect() { chatReconnectRequested_ = true; wake(); }
+
+    // Runs a tick now instead of at the next scheduled slot
+    void wake();
+    TickStats tickStats() const;
 
 private:
     void switcherThread();
-    void doSwitchCheck();
-    void updateStatusCache();
+    void tick();
+    void doSwitchCheck(const ServerSample &sample, const ConfigPtr &cfg);
+    void publishStatusLocked(SwitchType type, const ConfigPtr &cfg);
     
-    SwitchType getOnlineServerStatus(StreamServer** activeServer);
-    SwitchType getOnlineServerStatusLocked(StreamServer** activeServer);
+    ServerSample readSamples(const ConfigPtr &cfg);
+    ServerSample readSamplesLocked(const ConfigPtr &cfg);
+    StreamServer* findServerLocked(const std::string &name);
     void switchToScene(const std::string &sceneName);
-    std::string getSceneForType(SwitchType type, StreamServer* server = nullptr);
+    std::string getSceneForType(SwitchType type, StreamServer* server, const ConfigPtr &cfg);
     
-    bool isSceneSwitchable(const std::string &scene);
+    bool isSceneSwitchable(const std::string &scene, const ConfigPtr &cfg);
     
     void handleStartingScene();
-    void handleOfflineTimeout();
+    void handleOfflineTimeout(const ConfigPtr &cfg);
     void handleChatCommand(const ChatMessage& msg);
     void handleCustomCommands(const ChatMessage& msg);
     void handleRaidStop(const std::string &targetLogin, const std::string &displayName);
     void announceSceneChange(SwitchType type);
     void sendChatMessage(const std::string &text);
     std::string formatTemplate(const std::string &tmpl, const std::string &sceneOverride = "");
+    std::string formatTemplate(const std::string &tmpl, const SwitcherStatus &status,
+                               const std::string &sceneOverride);
 
     Config *config_;
     std::unique_ptr<ChatClient> twitchChat_;
     std::unique_ptr<KickChatClient> kickChat_;
     std::unique_ptr<TwitchPubSubClient> twitchPubSub_;
     mutable std::mutex chatMutex_;
-    std::vector<std::unique_ptr<StreamServer>> servers_;
+    std::vector<std::shared_ptr<StreamServer>> servers_;
+    Sampler sampler_;
     
     std::thread switcherThread_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    bool wakeRequested_ = false;
+    Histogram tickJitter_;
+    Histogram tickOverrun_;
+    std::atomic<uint64_t> ticks_{0};
+    std::atomic<uint64_t> ticksMissed_{0};
     std::thread refreshThread_;
     std::atomic<bool> refreshing_{false};
     std::atomic<bool> running_{false};
@@ -112,31 +161,28 @@ private:
     std::chrono::steady_clock::time_point pubsubNextRetry_;
     int pubsubRetryDelay_ = 0;
     mutable std::mutex mutex_;
-    mutable std::mutex statusCacheMutex_;
 
     SwitchType prevSwitchType_ = SwitchType::Offline;
-    uint8_t sameTypeCount_ = 0;
     std::chrono::steady_clock::time_point sameTypeStart_;
     std::chrono::steady_clock::time_point offlineStart_;
     std::chrono::steady_clock::time_point streamStartTime_;
     
-    std::string currentScene_;
+    LatestSlot<std::string> currentScene_;
     std::string prevScene_;
     std::string lastUsedServerName_;
     bool wasOnStartingScene_ = false;
 
     BitrateInfo lastBitrateInfo_;
-    
-    // Cached UI strings updated by switcher thread, read by UI timer
-    std::string cachedStatusString_;
-    std::string cachedBitrateString_;
+
+    LatestSlot<SwitcherStatus> status_;
+    uint64_t statusVersion_ = 0;
 
     // RIST stale frame fix
     bool ristFixPending_ = false;
     bool ristFixFired_ = false;
     bool hasBeenOnline_ = false;
     std::chrono::steady_clock::time_point ristFixTriggerTime_;
-    void handleRistStaleFrameFix(bool offline);
+    void handleRistStaleFrameFix(bool offline, const ConfigPtr &cfg);
 };
 
 } // namespace BitrateSwitch
@@ -18,6 +18,11 @@ namespace BitrateSwitch {
 
 static const char *kPubSubUrl = "wss://pubsub-edge.twitch.tv";
 
+// twitch wants a PING at least every 5min
+static constexpr int kPingSec = 280;
+// how often that and pending LISTENs are checked
+static constexpr int kCheckSec = 5;
+
 struct RaidPack {
 	TwitchPubSubClient::RaidCallback cb;
 	std::string login;
@@ -65,23 +70,32 @@ void TwitchPubSubClient::subscribeRaid(const std::string &broadcasterUserId)
 	}
 	topics_.push_back(std::move(topic));
 	resendListen_ = true;
+#ifndef _WIN32
+	// a live session sends it now rather than at its next check
+	reactor_->fireTimer(reactorId_);
+#endif
 }
 
 void TwitchPubSubClient::start()
 {
 	if (running_.exchange(true))
 		return;
+	ws_.clearInterrupt();
 	worker_ = std::thread([this]() { workerMain(); });
 }
 
 void TwitchPubSubClient::stop()
 {
 	running_ = false;
-	// let the worker notice running_ via its 1s recv timeout and exit
-	// before we tear down the socket -- libcurl is not safe against
-	// freeing the easy handle while another thread is in curl_ws_recv
+	// wake the worker out of connect/recv and let it exit before we
+	// tear down the socket -- libcurl is not safe against freeing the
+	// easy handle while another thread is in curl_ws_recv
+	ws_.interrupt();
 	if (worker_.joinable())
 		worker_.join();
+#ifndef _WIN32
+	reactor_->remove(reactorId_.exchange(0));
+#endif
 	ws_.disconnect();
 	connected_ = false;
 }
@@ -122,16 +136,17 @@ void TwitchPubSubClient::flushListen()
 	ws_.send(json);
 }
 
-void TwitchPubSubClient::workerMain()
+bool TwitchPubSubClient::openSession()
 {
 	blog(LOG_INFO, "[BitrateSceneSwitch] PubSub: Connecting to %s",
 	     kPubSubUrl);
 
 	if (!ws_.connect(kPubSubUrl)) {
-		blog(LOG_WARNING,
-		     "[BitrateSceneSwitch] PubSub: failed to connect");
+		if (running_)
+			blog(LOG_WARNING,
+			     "[BitrateSceneSwitch] PubSub: failed to connect");
 		connected_ = false;
-		return;
+		return false;
 	}
 
 	blog(LOG_INFO, "[BitrateSceneSwitch] PubSub: Connected");
@@ -144,135 +159,169 @@ void TwitchPubSubClient::workerMain()
 			 .toJson(QJsonDocument::Compact)
 			 .toStdString());
 
-	auto lastPing = std::chrono::steady_clock::now();
+	lastPing_ = std::chrono::steady_clock::now();
+	return true;
+}
 
-	while (running_) {
-		bool flush = false;
-		{
-			std::lock_guard<std::mutex> lock(mutex_);
-			flush = resendListen_;
-		}
-		if (flush && ws_.isConnected())
-			flushListen();
+void TwitchPubSubClient::closeSession()
+{
+	blog(LOG_WARNING, "[BitrateSceneSwitch] PubSub: Disconnected");
+	connected_ = false;
+}
 
+bool TwitchPubSubClient::onReadable()
+{
+	for (;;) {
 		std::string raw;
-		auto result = ws_.recv(raw);
-
-		if (result == WsClient::RecvResult::Timeout) {
-			auto elapsed =
-				std::chrono::duration_cast<
-					std::chrono::seconds>(
-					std::chrono::steady_clock::now() -
-					lastPing)
-					.count();
-			if (elapsed >= 280) {
-				QJsonObject ping;
-				ping["type"] = QStringLiteral("PING");
-				ping["nonce"] = QString::number(++nonce_);
-				std::string pj =
-					QJsonDocument(ping)
-						.toJson(QJsonDocument::Compact)
-						.toStdString();
-				ws_.send(pj);
-				lastPing = std::chrono::steady_clock::now();
-			}
-			continue;
+		auto result = ws_.tryRecv(raw);
+		if (result == WsClient::RecvResult::Timeout)
+			return true;
+		if (result != WsClient::RecvResult::Message ||
+		    !handleMessage(raw)) {
+			closeSession();
+			return false;
 		}
+	}
+}
 
-		if (result != WsClient::RecvResult::Message)
-			break;
-
-		RaidCallback cbCopy;
-		{
-			std::lock_guard<std::mutex> lock(mutex_);
-			cbCopy = raidCb_;
-		}
+bool TwitchPubSubClient::onTimer()
+{
+	bool flush = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		flush = resendListen_;
+	}
+	if (flush && ws_.isConnected())
+		flushListen();
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+			       std::chrono::steady_clock::now() - lastPing_)
+			       .count();
+	if (elapsed >= kPingSec) {
+		QJsonObject ping;
+		ping["type"] = QStringLiteral("PING");
+		ping["nonce"] = QString::number(++nonce_);
+		std::string pj = QJsonDocument(ping)
+					 .toJson(QJsonDocument::Compact)
+					 .toStdString();
+		ws_.send(pj);
+		lastPing_ = std::chrono::steady_clock::now();
+	}
+	return true;
+}
 
-		QJsonParseError err{};
-		QJsonDocument doc =
-			QJsonDocument::fromJson(QByteArray::fromStdString(raw),
-						&err);
-		if (err.error != QJsonParseError::NoError || !doc.isObject())
-			continue;
-		QJsonObject o = doc.object();
-		QString msgType = o.value(QLatin1String("type")).toString();
-
-		if (msgType == QLatin1String("RESPONSE")) {
-			QString error = o.value(QLatin1String("error")).toString();
-			if (!error.isEmpty()) {
-				blog(LOG_WARNING,
-				     "[BitrateSceneSwitch] PubSub LISTEN error: %s (giving up, fix config and reconnect)",
-				     error.toUtf8().constData());
-				// don't burn cycles retrying a known-bad topic;
-				// the switcher backoff will not restart us
-				// because pubsubWasConnected_ stays false here.
-				running_ = false;
-				break;
-			}
-			blog(LOG_INFO,
-			     "[BitrateSceneSwitch] PubSub LISTEN acknowledged");
-			continue;
-		}
+bool TwitchPubSubClient::handleMessage(const std::string &raw)
+{
+	RaidCallback cbCopy;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		cbCopy = raidCb_;
+	}
 
-		if (msgType == QLatin1String("PONG")) {
-			blog(LOG_DEBUG,
-			     "[BitrateSceneSwitch] PubSub: PONG received");
-			continue;
+	QJsonParseError err{};
+	QJsonDocument doc =
+		QJsonDocument::fromJson(QByteArray::fromStdString(raw),
+					&err);
+	if (err.error != QJsonParseError::NoError || !doc.isObject())
+		return true;
+	QJsonObject o = doc.object();
+	QString msgType = o.value(QLatin1String("type")).toString();
+
+	if (msgType == QLatin1String("RESPONSE")) {
+		QString error = o.value(QLatin1String("error")).toString();
+		if (!error.isEmpty()) {
+			blog(LOG_WARNING,
+			     "[BitrateSceneSwitch] PubSub LISTEN error: %s (giving up, fix config and reconnect)",
+			     error.toUtf8().constData());
+			// don't burn cycles retrying a known-bad topic;
+			// the switcher backoff will not restart us
+			// because pubsubWasConnected_ stays false here.
+			running_ = false;
+			return false;
 		}
+		blog(LOG_INFO,
+		     "[BitrateSceneSwitch] PubSub LISTEN acknowledged");
+		return true;
+	}
 
-		if (msgType != QLatin1String("MESSAGE"))
-			continue;
-		QJsonObject data = o.value(QLatin1String("data")).toObject();
-		QString innerStr =
-			data.value(QLatin1String("message")).toString();
-		if (innerStr.isEmpty())
-			continue;
-
-		QJsonDocument innerDoc =
-			QJsonDocument::fromJson(innerStr.toUtf8(), &err);
-		if (err.error != QJsonParseError::NoError ||
-		    !innerDoc.isObject())
-			continue;
-		QJsonObject innerObj = innerDoc.object();
-		if (innerObj.value(QLatin1String("type")).toString() !=
-		    QLatin1String("raid_go_v2"))
-			continue;
-		QJsonObject raid =
-			innerObj.value(QLatin1String("raid")).toObject();
-		QString targetLogin =
-			raid.value(QLatin1String("target_login")).toString();
-		QString display =
-			raid.value(QLatin1String("target_display_name"))
-				.toString();
-		if (targetLogin.isEmpty())
-			continue;
+	if (msgType == QLatin1String("PONG")) {
+		blog(LOG_DEBUG,
+		     "[BitrateSceneSwitch] PubSub: PONG received");
+		return true;
+	}
 
+	if (msgType != QLatin1String("MESSAGE"))
+		return true;
+	QJsonObject data = o.value(QLatin1String("data")).toObject();
+	QString innerStr =
+		data.value(QLatin1String("message")).toString();
+	if (innerStr.isEmpty())
+		return true;
+
+	QJsonDocument innerDoc =
+		QJsonDocument::fromJson(innerStr.toUtf8(), &err);
+	if (err.error != QJsonParseError::NoError ||
+	    !innerDoc.isObject())
+		return true;
+	QJsonObject innerObj = innerDoc.object();
+	if (innerObj.value(QLatin1String("type")).toString() !=
+	    QLatin1String("raid_go_v2"))
+		return true;
+	QJsonObject raid =
+		innerObj.value(QLatin1String("raid")).toObject();
+	QString targetLogin =
+		raid.value(QLatin1String("target_login")).toString();
+	QString display =
+		raid.value(QLatin1String("target_display_name"))
+			.toString();
+	if (targetLogin.isEmpty())
+		return true;
+
+	blog(LOG_INFO,
+	     "[BitrateSceneSwitch] PubSub: raid_go_v2 detected -> %s (%s)",
+	     targetLogin.toUtf8().constData(),
+	     display.toUtf8().constData());
+
+	auto now = std::chrono::steady_clock::now();
+	if (haveLastRaidEmit_ &&
+	    std::chrono::duration_cast<std::chrono::seconds>(
+		    now - lastRaidEmit_)
+			    .count() < 10) {
 		blog(LOG_INFO,
-		     "[BitrateSceneSwitch] PubSub: raid_go_v2 detected -> %s (%s)",
-		     targetLogin.toUtf8().constData(),
-		     display.toUtf8().constData());
-
-		auto now = std::chrono::steady_clock::now();
-		if (haveLastRaidEmit_ &&
-		    std::chrono::duration_cast<std::chrono::seconds>(
-			    now - lastRaidEmit_)
-				    .count() < 10) {
-			blog(LOG_INFO,
-			     "[BitrateSceneSwitch] PubSub: duplicate raid suppressed (10s cooldown)");
-			continue;
-		}
-		haveLastRaidEmit_ = true;
-		lastRaidEmit_ = now;
-
-		if (cbCopy)
-			queueRaidCallback(std::move(cbCopy),
-					  targetLogin.toStdString(),
-					  display.toStdString());
+		     "[BitrateSceneSwitch] PubSub: duplicate raid suppressed (10s cooldown)");
+		return true;
 	}
+	haveLastRaidEmit_ = true;
+	lastRaidEmit_ = now;
+
+	if (cbCopy)
+		queueRaidCallback(std::move(cbCopy),
+				  targetLogin.toStdString(),
+				  display.toStdString());
+	return true;
+}
 
-	blog(LOG_WARNING, "[BitrateSceneSwitch] PubSub: Disconnected");
+void TwitchPubSubClient::workerMain()
+{
+	if (!openSession())
+		return;
+
+#ifdef _WIN32
+	while (running_ && onReadable() && onTimer()) {
+	}
+	if (connected_)
+		closeSession();
 	ws_.disconnect();
-	connected_ = false;
+#else
+	// hand the session over; the socket is left open until stop() so
+	// its number can't be reused while the reactor still watches it
+	reactorId_ = reactor_->add(
+		ws_.activeSocket(), [this] { return onReadable(); },
+		[this] { return onTimer(); },
+		std::chrono::seconds(kCheckSec));
+	if (reactorId_ == 0)
+		connected_ = false;
+#endif
 }
 
 } // namespace BitrateSwitch
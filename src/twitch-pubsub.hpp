@@ -1,9 +1,11 @@
 #pragma once
 
+#include "net-reactor.hpp"
 #include "ws-client.hpp"
 #include <atomic>
 #include <chrono>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -26,7 +28,15 @@ public:
 	bool isConnected() const;
 
 private:
+	// The worker only connects; the session then runs on the network
+	// reactor (or stays on the worker on Windows). The handlers return
+	// false once the connection is gone.
 	void workerMain();
+	bool openSession();
+	void closeSession();
+	bool onReadable();
+	bool onTimer();
+	bool handleMessage(const std::string &raw);
 	void flushListen();
 
 	RaidCallback raidCb_;
@@ -37,7 +47,13 @@ private:
 	std::atomic<bool> connected_{false};
 	WsClient ws_;
 	std::thread worker_;
+#ifndef _WIN32
+	const std::shared_ptr<NetReactor> reactor_ = NetReactor::shared();
+	// read by subscribeRaid() while the worker registers
+	std::atomic<NetReactor::Id> reactorId_{0};
+#endif
 	int nonce_ = 0;
+	std::chrono::steady_clock::time_point lastPing_;
 
 	std::chrono::steady_clock::time_point lastRaidEmit_;
 	bool haveLastRaidEmit_ = false;
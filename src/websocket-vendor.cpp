@@ -75,7 +75,7 @@ void WebSocketVendor::onGetSettings(obs_data_t *requestData, obs_data_t *respons
     auto *self = static_cast<WebSocketVendor*>(priv_data);
     if (!self->config_) return;
 
-    Config *cfg = self->config_;
+    ConfigPtr cfg = self->config_->snapshot();
 
     // Core settings
     obs_data_set_bool(responseData, "enabled", cfg->enabled);
@@ -168,8 +168,60 @@ void WebSocketVendor::onGetStatus(obs_data_t *requestData, obs_data_t *responseD
     obs_data_set_double(responseData, "rttMs", info.rttMs);
     obs_data_set_bool(responseData, "isOnline", info.isOnline);
     obs_data_set_string(responseData, "serverName", info.serverName.c_str());
+    obs_data_set_string(responseData, "publisher", info.publisher.c_str());
     obs_data_set_string(responseData, "statusMessage", info.message.c_str());
     obs_data_set_bool(responseData, "enabled", self->config_ ? self->config_->enabled : false);
+
+    obs_data_set_int(responseData, "configVersion",
+                     static_cast<long long>(self->switcher_->getStatus()->configVersion));
+
+    ConnectionStats conns = HttpClient::connectionStats();
+    obs_data_set_int(responseData, "connectionsNew", static_cast<long long>(conns.newConnections));
+    obs_data_set_int(responseData, "connectionsReused", static_cast<long long>(conns.reusedConnections));
+    obs_data_set_int(responseData, "statsTransfers", static_cast<long long>(conns.transfers));
+    obs_data_set_int(responseData, "statsBytesOnWire", static_cast<long long>(conns.bytesOnWire));
+    obs_data_set_int(responseData, "statsNotModified", static_cast<long long>(conns.notModified));
+
+    HedgeStats hedges = PollEngine::hedgeStats();
+    obs_data_set_int(responseData, "hedgeEligible", static_cast<long long>(hedges.eligible));
+    obs_data_set_int(responseData, "hedgesSent", static_cast<long long>(hedges.sent));
+    obs_data_set_int(responseData, "hedgeWins", static_cast<long long>(hedges.wins));
+
+    // Histogram buckets as {upToMs, count}; the last bucket has no bound
+    TickStats ticks = self->switcher_->tickStats();
+    obs_data_set_int(responseData, "ticks", static_cast<long long>(ticks.ticks));
+    obs_data_set_int(responseData, "ticksMissed", static_cast<long long>(ticks.missed));
+    auto setHistogram = [responseData](const char *name, const std::array<uint64_t, Histogram::kBuckets> &counts) {
+        obs_data_array_t *buckets = obs_data_array_create();
+        for (size_t i = 0; i < counts.size(); i++) {
+            obs_data_t *bucket = obs_data_create();
+            if (i < Histogram::kBoundsMs.size())
+                obs_data_set_double(bucket, "upToMs", Histogram::kBoundsMs[i]);
+            obs_data_set_int(bucket, "count", static_cast<long long>(counts[i]));
+            obs_data_array_push_back(buckets, bucket);
+            obs_data_release(bucket);
+        }
+        obs_data_set_array(responseData, name, buckets);
+        obs_data_array_release(buckets);
+    };
+    setHistogram("tickJitter", ticks.jitter);
+    setHistogram("tickOverrun", ticks.overrun);
+
+    std::shared_ptr<const SwitcherStatus> status = self->switcher_->getStatus();
+    obs_data_array_t *serversArray = obs_data_array_create();
+    for (const auto &health : status->servers) {
+        obs_data_t *serverData = obs_data_create();
+        obs_data_set_string(serverData, "name", health.name.c_str());
+        obs_data_set_string(serverData, "breaker", CircuitBreaker::stateName(health.breaker));
+        obs_data_set_int(serverData, "failures", health.failures);
+        obs_data_set_int(serverData, "retryInMs", static_cast<long long>(health.retryInMs));
+        obs_data_set_double(serverData, "p50Ms", health.p50Ms);
+        obs_data_set_double(serverData, "p99Ms", health.p99Ms);
+        obs_data_array_push_back(serversArray, serverData);
+        obs_data_release(serverData);
+    }
+    obs_data_set_array(responseData, "servers", serversArray);
+    obs_data_array_release(serversArray);
 }
 
 void WebSocketVendor::onSwitchScene(obs_data_t *requestData, obs_data_t *responseData, void *priv_data)
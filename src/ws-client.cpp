@@ -52,6 +52,10 @@ bool WsClient::connect(const std::string &url)
 	if (path.empty())
 		path = L"/";
 
+	std::unique_lock<std::mutex> lock(handleMutex_);
+	if (interrupted_)
+		return false;
+
 	session_ = WinHttpOpen(L"BitrateSceneSwitch/1.0",
 			       WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
 			       WINHTTP_NO_PROXY_NAME,
@@ -70,7 +74,7 @@ bool WsClient::connect(const std::string &url)
 
 	connect_ = WinHttpConnect(session_, host.c_str(), uc.nPort, 0);
 	if (!connect_) {
-		disconnect();
+		closeHandlesLocked();
 		return false;
 	}
 
@@ -78,45 +82,42 @@ bool WsClient::connect(const std::string &url)
 	if (secure)
 		flags |= WINHTTP_FLAG_SECURE;
 
-	HINTERNET request = WinHttpOpenRequest(
+	request_ = WinHttpOpenRequest(
 		connect_, L"GET", path.c_str(), nullptr,
 		WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, flags);
-	if (!request) {
-		disconnect();
-		return false;
-	}
-
-	if (!WinHttpSetOption(request,
+	if (!request_ ||
+	    !WinHttpSetOption(request_,
 			      WINHTTP_OPTION_UPGRADE_TO_WEB_SOCKET,
 			      nullptr, 0)) {
-		WinHttpCloseHandle(request);
-		disconnect();
+		closeHandlesLocked();
 		return false;
 	}
 
 	DWORD keepAlive = 30000;
-	WinHttpSetOption(request,
+	WinHttpSetOption(request_,
 			 WINHTTP_OPTION_WEB_SOCKET_KEEPALIVE_INTERVAL,
 			 &keepAlive, sizeof(keepAlive));
 
-	if (!WinHttpSendRequest(request, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-				WINHTTP_NO_REQUEST_DATA, 0, 0, 0)) {
-		WinHttpCloseHandle(request);
-		disconnect();
-		return false;
-	}
-
-	if (!WinHttpReceiveResponse(request, nullptr)) {
-		WinHttpCloseHandle(request);
-		disconnect();
+	// the handshake is the long wait; interrupt() closing request_
+	// makes either call fail right away
+	HINTERNET request = request_;
+	lock.unlock();
+	bool upgraded = WinHttpSendRequest(request, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
+					   WINHTTP_NO_REQUEST_DATA, 0, 0, 0) &&
+			WinHttpReceiveResponse(request, nullptr);
+	lock.lock();
+
+	if (!upgraded || interrupted_) {
+		closeHandlesLocked();
 		return false;
 	}
 
-	websocket_ = WinHttpWebSocketCompleteUpgrade(request, 0);
-	WinHttpCloseHandle(request);
+	websocket_ = WinHttpWebSocketCompleteUpgrade(request_, 0);
+	WinHttpCloseHandle(request_);
+	request_ = nullptr;
 
 	if (!websocket_) {
-		disconnect();
+		closeHandlesLocked();
 		return false;
 	}
 
@@ -124,29 +125,49 @@ bool WsClient::connect(const std::string &url)
 	return true;
 }
 
+void WsClient::interrupt()
+{
+	// closing the handles aborts a synchronous WinHTTP call in progress
+	// on them; the owner is shutting this client down anyway
+	std::lock_guard<std::mutex> lock(handleMutex_);
+	interrupted_ = true;
+	connected_ = false;
+	closeHandlesLocked();
+}
+
+void WsClient::clearInterrupt()
+{
+	interrupted_ = false;
+}
+
 void WsClient::disconnect()
 {
+	std::lock_guard<std::mutex> lock(handleMutex_);
 	connected_ = false;
-	if (websocket_) {
-		WinHttpCloseHandle(websocket_);
-		websocket_ = nullptr;
-	}
-	if (connect_) {
-		WinHttpCloseHandle(connect_);
-		connect_ = nullptr;
-	}
-	if (session_) {
-		WinHttpCloseHandle(session_);
-		session_ = nullptr;
+	closeHandlesLocked();
+}
+
+void WsClient::closeHandlesLocked()
+{
+	for (HINTERNET *handle : {&request_, &websocket_, &connect_, &session_}) {
+		if (*handle) {
+			WinHttpCloseHandle(*handle);
+			*handle = nullptr;
+		}
 	}
 }
 
 bool WsClient::send(const std::string &text)
 {
-	if (!websocket_ || !connected_)
+	HINTERNET websocket;
+	{
+		std::lock_guard<std::mutex> lock(handleMutex_);
+		websocket = websocket_;
+	}
+	if (!websocket || !connected_)
 		return false;
 	DWORD err = WinHttpWebSocketSend(
-		websocket_, WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE,
+		websocket, WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE,
 		(PVOID)text.data(), (DWORD)text.size());
 	if (err != NO_ERROR) {
 		connected_ = false;
@@ -158,16 +179,25 @@ bool WsClient::send(const std::string &text)
 WsClient::RecvResult WsClient::recv(std::string &out)
 {
 	out.clear();
-	if (!websocket_ || !connected_)
+	if (interrupted_)
+		return RecvResult::Interrupted;
+	HINTERNET websocket;
+	{
+		std::lock_guard<std::mutex> lock(handleMutex_);
+		websocket = websocket_;
+	}
+	if (!websocket || !connected_)
 		return RecvResult::Error;
 
 	char buf[8192];
 	for (;;) {
 		DWORD bytesRead = 0;
 		WINHTTP_WEB_SOCKET_BUFFER_TYPE type;
-		DWORD err = WinHttpWebSocketReceive(websocket_, buf,
+		DWORD err = WinHttpWebSocketReceive(websocket, buf,
 						    sizeof(buf),
 						    &bytesRead, &type);
+		if (interrupted_)
+			return RecvResult::Interrupted;
 		if (err == ERROR_WINHTTP_TIMEOUT)
 			return RecvResult::Timeout;
 		if (err != NO_ERROR) {
@@ -190,20 +220,80 @@ bool WsClient::isConnected() const
 	return connected_;
 }
 
+int WsClient::activeSocket() const
+{
+	return -1;
+}
+
+WsClient::RecvResult WsClient::tryRecv(std::string &out)
+{
+	return recv(out);
+}
+
 } // namespace BitrateSwitch
 
 #else // !_WIN32 — POSIX + libcurl WebSocket
 
 #include <curl/websockets.h>
+#include <fcntl.h>
 #include <poll.h>
+#include <unistd.h>
 
 namespace BitrateSwitch {
 
-WsClient::WsClient() = default;
+namespace {
+
+// how long recv() waits before reporting Timeout, so callers can run
+// their ping and liveness timers
+constexpr int kRecvWaitMs = 1000;
+
+void setNonBlocking(int fd)
+{
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+} // anonymous namespace
+
+WsClient::WsClient()
+{
+	if (pipe(wakeFds_) == 0) {
+		setNonBlocking(wakeFds_[0]);
+		setNonBlocking(wakeFds_[1]);
+	} else {
+		wakeFds_[0] = wakeFds_[1] = -1;
+		blog(LOG_WARNING,
+		     "[BitrateSceneSwitch] WS: no wake pipe, interrupt falls back to timeouts");
+	}
+}
 
 WsClient::~WsClient()
 {
 	disconnect();
+	if (wakeFds_[0] >= 0)
+		close(wakeFds_[0]);
+	if (wakeFds_[1] >= 0)
+		close(wakeFds_[1]);
+}
+
+void WsClient::interrupt()
+{
+	interrupted_ = true;
+	if (wakeFds_[1] >= 0) {
+		char byte = 1;
+		ssize_t n = write(wakeFds_[1], &byte, 1);
+		(void)n; // a full pipe is already readable
+	}
+}
+
+void WsClient::clearInterrupt()
+{
+	interrupted_ = false;
+	if (wakeFds_[0] >= 0) {
+		char drain[64];
+		while (read(wakeFds_[0], drain, sizeof(drain)) > 0) {
+		}
+	}
 }
 
 bool WsClient::connect(const std::string &url)
@@ -211,25 +301,65 @@ bool WsClient::connect(const std::string &url)
 	disconnect();
 
 	curl_ = curl_easy_init();
-	if (!curl_)
+	multi_ = curl_multi_init();
+	if (!curl_ || !multi_) {
+		disconnect();
 		return false;
+	}
 
 	curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
 	curl_easy_setopt(curl_, CURLOPT_CONNECT_ONLY, 2L);
 	// bound the connect handshake so a dead route can't wedge us for
 	// libcurl's default 5min connect timeout. these only apply during
-	// curl_easy_perform; once we switch to ws send/recv they no longer
+	// the handshake; once we switch to ws send/recv they no longer
 	// gate the long-running session.
 	curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, 5000L);
 	curl_easy_setopt(curl_, CURLOPT_TIMEOUT_MS, 10000L);
 
-	CURLcode res = curl_easy_perform(curl_);
+	// drive the handshake on our own multi handle so the wait includes
+	// the wake pipe and interrupt() cuts it short
+	curl_multi_add_handle(multi_, curl_);
+	CURLcode res = CURLE_OK;
+	for (;;) {
+		if (interrupted_) {
+			disconnect();
+			return false;
+		}
+
+		int running = 0;
+		CURLMcode mc = curl_multi_perform(multi_, &running);
+		if (mc != CURLM_OK) {
+			blog(LOG_WARNING,
+			     "[BitrateSceneSwitch] WS connect failed: %s",
+			     curl_multi_strerror(mc));
+			disconnect();
+			return false;
+		}
+
+		bool done = false;
+		int queued = 0;
+		CURLMsg *msg;
+		while ((msg = curl_multi_info_read(multi_, &queued))) {
+			if (msg->msg == CURLMSG_DONE) {
+				res = msg->data.result;
+				done = true;
+			}
+		}
+		if (done)
+			break;
+
+		struct curl_waitfd wake = {};
+		wake.fd = wakeFds_[0];
+		wake.events = CURL_WAIT_POLLIN;
+		curl_multi_poll(multi_, &wake, wakeFds_[0] >= 0 ? 1 : 0,
+				kRecvWaitMs, nullptr);
+	}
+
 	if (res != CURLE_OK) {
 		blog(LOG_WARNING,
 		     "[BitrateSceneSwitch] WS connect failed: %s",
 		     curl_easy_strerror(res));
-		curl_easy_cleanup(curl_);
-		curl_ = nullptr;
+		disconnect();
 		return false;
 	}
 
@@ -243,9 +373,15 @@ void WsClient::disconnect()
 	if (curl_) {
 		size_t sent = 0;
 		curl_ws_send(curl_, "", 0, &sent, 0, CURLWS_CLOSE);
+		if (multi_)
+			curl_multi_remove_handle(multi_, curl_);
 		curl_easy_cleanup(curl_);
 		curl_ = nullptr;
 	}
+	if (multi_) {
+		curl_multi_cleanup(multi_);
+		multi_ = nullptr;
+	}
 }
 
 bool WsClient::send(const std::string &text)
@@ -266,6 +402,8 @@ bool WsClient::send(const std::string &text)
 WsClient::RecvResult WsClient::recv(std::string &out)
 {
 	out.clear();
+	if (interrupted_)
+		return RecvResult::Interrupted;
 	if (!curl_ || !connected_)
 		return RecvResult::Error;
 
@@ -277,11 +415,17 @@ WsClient::RecvResult WsClient::recv(std::string &out)
 		return RecvResult::Error;
 	}
 
-	struct pollfd pfd;
-	pfd.fd = sockfd;
-	pfd.events = POLLIN;
-	int pr = poll(&pfd, 1, 1000);
-
+	struct pollfd pfd[2];
+	pfd[0].fd = sockfd;
+	pfd[0].events = POLLIN;
+	pfd[0].revents = 0;
+	pfd[1].fd = wakeFds_[0];
+	pfd[1].events = POLLIN;
+	pfd[1].revents = 0;
+	int pr = poll(pfd, wakeFds_[0] >= 0 ? 2 : 1, kRecvWaitMs);
+
+	if (interrupted_)
+		return RecvResult::Interrupted;
 	if (pr == 0)
 		return RecvResult::Timeout;
 	if (pr < 0) {
@@ -289,11 +433,37 @@ WsClient::RecvResult WsClient::recv(std::string &out)
 		return RecvResult::Error;
 	}
 
+	return readMessage(out);
+}
+
+WsClient::RecvResult WsClient::tryRecv(std::string &out)
+{
+	out.clear();
+	if (interrupted_)
+		return RecvResult::Interrupted;
+	if (!curl_ || !connected_)
+		return RecvResult::Error;
+	return readMessage(out);
+}
+
+int WsClient::activeSocket() const
+{
+	if (!curl_)
+		return -1;
+	curl_socket_t sockfd = CURL_SOCKET_BAD;
+	if (curl_easy_getinfo(curl_, CURLINFO_ACTIVESOCKET, &sockfd) != CURLE_OK ||
+	    sockfd == CURL_SOCKET_BAD)
+		return -1;
+	return static_cast<int>(sockfd);
+}
+
+WsClient::RecvResult WsClient::readMessage(std::string &out)
+{
 	char buf[8192];
 	for (;;) {
 		size_t rlen = 0;
 		const struct curl_ws_frame *meta = nullptr;
-		res = curl_ws_recv(curl_, buf, sizeof(buf), &rlen, &meta);
+		CURLcode res = curl_ws_recv(curl_, buf, sizeof(buf), &rlen, &meta);
 
 		if (res == CURLE_AGAIN)
 			break;
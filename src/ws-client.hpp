@@ -16,13 +16,14 @@
 #endif
 
 #include <atomic>
+#include <mutex>
 #include <string>
 
 namespace BitrateSwitch {
 
 class WsClient {
 public:
-	enum class RecvResult { Message, Timeout, Error, Closed };
+	enum class RecvResult { Message, Timeout, Error, Closed, Interrupted };
 
 	WsClient();
 	~WsClient();
@@ -33,15 +34,42 @@ public:
 	RecvResult recv(std::string &out);
 	bool isConnected() const;
 
+	// For driving the session from a NetReactor: the connected socket
+	// (-1 on Windows, where WinHTTP keeps it), and a recv() that doesn't
+	// wait and returns Timeout when no message is ready. On Windows
+	// tryRecv() waits like recv() does.
+	int activeSocket() const;
+	RecvResult tryRecv(std::string &out);
+
+	// Makes a blocked connect() or recv() on another thread return right
+	// away; sticks until clearInterrupt() so an owner shutting down can
+	// call it before its worker has even started connecting
+	void interrupt();
+	void clearInterrupt();
+
 private:
+#ifndef _WIN32
+	RecvResult readMessage(std::string &out);
+#endif
+
 #ifdef _WIN32
+	void closeHandlesLocked();
+
+	// interrupt() closes the handles to abort a synchronous call in
+	// progress; blocking calls run on a copy taken under the lock
+	std::mutex handleMutex_;
 	HINTERNET session_ = nullptr;
 	HINTERNET connect_ = nullptr;
+	HINTERNET request_ = nullptr;
 	HINTERNET websocket_ = nullptr;
 #else
 	CURL *curl_ = nullptr;
+	CURLM *multi_ = nullptr;
+	// self-pipe: interrupt() writes, connect()/recv() poll the read end
+	int wakeFds_[2] = {-1, -1};
 #endif
 	std::atomic<bool> connected_{false};
+	std::atomic<bool> interrupted_{false};
 };
 
 } // namespace BitrateSwitch
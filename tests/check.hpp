@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertions for the test executables: a failed CHECK is reported
+// and counted, and main() returns the count so ctest sees the failure.
+namespace TestSupport {
+
+inline int &failures()
+{
+    static int count = 0;
+    return count;
+}
+
+} // namespace TestSupport
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__,    \
+                         #cond);                                                     \
+            TestSupport::failures()++;                                               \
+        }                                                                            \
+    } while (0)
+
+#define TEST_RESULT() (TestSupport::failures() == 0 ? 0 : 1)
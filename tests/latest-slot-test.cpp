@@ -0,0 +1,126 @@
+// Readers of a LatestSlot (the switcher's status, GetStatus, scene-change
+// callbacks) must never wait on the thread that publishes into it, even
+// while that thread is stuck on a hanging server.
+
+#include "check.hpp"
+#include "latest-slot.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace BitrateSwitch;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Status {
+    std::string scene;
+    int64_t bitrateKbps = 0;
+    uint64_t tick = 0;
+};
+
+// The publisher is blocked "in a poll" for as long as this test wants;
+// reads made meanwhile must return the last published value right away.
+void readsWhilePublisherHangs()
+{
+    LatestSlot<Status> slot;
+    slot.publish(Status{"Live", 6000, 1});
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool release = false;
+    std::atomic<bool> hanging{false};
+
+    std::thread publisher([&] {
+        slot.publish(Status{"Low", 400, 2});
+        std::unique_lock<std::mutex> lock(mutex);
+        hanging = true;
+        cv.wait(lock, [&] { return release; });
+        slot.publish(Status{"Live", 6000, 3});
+    });
+
+    while (!hanging)
+        std::this_thread::yield();
+
+    auto worst = Clock::duration::zero();
+    for (int i = 0; i < 10000; i++) {
+        auto start = Clock::now();
+        std::shared_ptr<const Status> status = slot.load();
+        worst = (std::max)(worst, Clock::now() - start);
+        CHECK(status && status->tick == 2 && status->scene == "Low");
+    }
+    // generous for a loaded CI box; a read that waited on the publisher
+    // would take as long as the hang
+    CHECK(worst < std::chrono::milliseconds(5));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    cv.notify_all();
+    publisher.join();
+    CHECK(slot.load()->tick == 3);
+}
+
+// A snapshot a reader holds stays as it was when it was loaded
+void snapshotsAreStable()
+{
+    LatestSlot<Status> slot;
+    CHECK(!slot.load());
+
+    slot.publish(Status{"Live", 6000, 1});
+    std::shared_ptr<const Status> held = slot.load();
+    slot.publish(Status{"Offline", 0, 2});
+
+    CHECK(held->tick == 1 && held->scene == "Live" && held->bitrateKbps == 6000);
+    CHECK(slot.load()->tick == 2);
+
+    slot.clear();
+    CHECK(!slot.load());
+    CHECK(held->tick == 1);
+}
+
+// Concurrent publishing and reading never shows a torn or stale-then-older value
+void concurrentReadersSeeOrderedValues()
+{
+    LatestSlot<Status> slot;
+    slot.publish(Status{"Live", 0, 0});
+    constexpr uint64_t kPublishes = 20000;
+
+    std::thread publisher([&] {
+        for (uint64_t tick = 1; tick <= kPublishes; tick++)
+            slot.publish(Status{"Live", static_cast<int64_t>(tick) * 10, tick});
+    });
+
+    std::atomic<bool> ordered{true};
+    auto reader = [&] {
+        uint64_t last = 0;
+        while (last < kPublishes) {
+            std::shared_ptr<const Status> status = slot.load();
+            if (status->tick < last || status->bitrateKbps != static_cast<int64_t>(status->tick) * 10)
+                ordered = false;
+            last = status->tick;
+        }
+    };
+    std::thread readerA(reader);
+    std::thread readerB(reader);
+
+    publisher.join();
+    readerA.join();
+    readerB.join();
+    CHECK(ordered);
+}
+
+} // anonymous namespace
+
+int main()
+{
+    readsWhilePublisherHangs();
+    snapshotsAreStable();
+    concurrentReadersSeeOrderedValues();
+    return TEST_RESULT();
+}
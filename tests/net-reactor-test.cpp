@@ -0,0 +1,121 @@
+// Output queued behind a full socket buffer has to go out as soon as the
+// peer drains it, not on the next inbound byte or liveness timer.
+
+#include "check.hpp"
+#include "net-reactor.hpp"
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace BitrateSwitch;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// Timers far enough out that only socket events can explain a call
+constexpr auto kTimerPeriod = std::chrono::seconds(60);
+
+bool waitFor(const std::atomic<int> &counter, int atLeast, std::chrono::milliseconds timeout)
+{
+    auto deadline = Clock::now() + timeout;
+    while (counter < atLeast && Clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return counter >= atLeast;
+}
+
+void fillSendBuffer(int fd)
+{
+    char chunk[4096] = {};
+    while (send(fd, chunk, sizeof(chunk), MSG_DONTWAIT) > 0) {
+    }
+}
+
+void drain(int fd)
+{
+    char chunk[4096];
+    while (recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT) > 0) {
+    }
+}
+
+void writableFiresOnlyWhileWatched()
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    fillSendBuffer(fds[0]);
+
+    NetReactor reactor;
+    std::atomic<int> readable{0};
+    std::atomic<int> writable{0};
+    std::atomic<int> timers{0};
+    NetReactor::Id id = reactor.add(
+        fds[0], [&] { readable++; return true; }, [&] { timers++; return true; }, kTimerPeriod,
+        [&] {
+            writable++;
+            // what a client does once its queue is flushed
+            reactor.watchWritable(id, false);
+            return true;
+        });
+    CHECK(id != 0);
+
+    // interest off: a writable socket must not call the handler
+    drain(fds[1]);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(writable == 0);
+
+    // full buffer, interest on: nothing until the peer reads
+    fillSendBuffer(fds[0]);
+    reactor.watchWritable(id, true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(writable == 0);
+
+    auto drainedAt = Clock::now();
+    drain(fds[1]);
+    CHECK(waitFor(writable, 1, std::chrono::milliseconds(1000)));
+    CHECK(Clock::now() - drainedAt < std::chrono::milliseconds(100));
+
+    // the handler switched interest off again
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(writable == 1);
+    CHECK(readable == 0);
+    CHECK(timers == 1); // the first timer fires right away
+
+    reactor.remove(id);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void writableHandlerCanDropRegistration()
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    NetReactor reactor;
+    std::atomic<int> writable{0};
+    NetReactor::Id id = reactor.add(
+        fds[0], [] { return true; }, [] { return true; }, kTimerPeriod,
+        [&] { writable++; return false; });
+    reactor.watchWritable(id, true);
+
+    CHECK(waitFor(writable, 1, std::chrono::milliseconds(1000)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(writable == 1);
+
+    // already gone; both are no-ops
+    reactor.watchWritable(id, true);
+    reactor.remove(id);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+} // anonymous namespace
+
+int main()
+{
+    writableFiresOnlyWhileWatched();
+    writableHandlerCanDropRegistration();
+    return TEST_RESULT();
+}
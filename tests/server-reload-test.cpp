@@ -0,0 +1,149 @@
+// A config reload must keep every server whose polling config is unchanged:
+// a rebuilt server starts with empty rate caches and no connections, and
+// its first readings can trip a false switch.
+
+#include "check.hpp"
+#include "server-reload.hpp"
+
+using namespace BitrateSwitch;
+
+namespace {
+
+StreamServerConfig server(const std::string &name, const std::string &url)
+{
+    StreamServerConfig config;
+    config.type = ServerType::SrtLiveServer;
+    config.name = name;
+    config.statsUrl = url;
+    config.key = "live/feed1";
+    return config;
+}
+
+std::vector<RunningServer> runningFrom(const std::vector<StreamServerConfig> &configs)
+{
+    std::vector<RunningServer> running;
+    for (const StreamServerConfig &config : configs)
+        running.push_back(RunningServer{config.name, hashServerConfig(config)});
+    return running;
+}
+
+std::vector<StreamServerConfig> baseline()
+{
+    return {
+        server("Primary", "http://10.0.0.1:8181/stats"),
+        server("Backup", "http://10.0.0.2:8181/stats"),
+        server("Cloud", "https://cloud.example/stats"),
+    };
+}
+
+void unchangedConfigKeepsEverything()
+{
+    std::vector<StreamServerConfig> configs = baseline();
+    std::vector<size_t> plan = planServerReload(runningFrom(configs), configs);
+    CHECK(plan == (std::vector<size_t>{0, 1, 2}));
+}
+
+// Scene overrides, priority and backup wiring are applied to a live server
+void sceneAndDependencyEditsKeep()
+{
+    std::vector<StreamServerConfig> before = baseline();
+    std::vector<StreamServerConfig> after = before;
+    after[0].overrideScenes.enabled = true;
+    after[0].overrideScenes.low = "Primary Low";
+    after[1].priority = 5;
+    after[2].dependsOn.enabled = true;
+    after[2].dependsOn.serverName = "Primary";
+
+    std::vector<size_t> plan = planServerReload(runningFrom(before), after);
+    CHECK(plan == (std::vector<size_t>{0, 1, 2}));
+}
+
+void pollingEditsRebuildOnlyThatServer()
+{
+    std::vector<StreamServerConfig> before = baseline();
+
+    std::vector<StreamServerConfig> url = before;
+    url[1].statsUrl = "http://10.0.0.3:8181/stats";
+    CHECK(planServerReload(runningFrom(before), url) == (std::vector<size_t>{0, kNewServer, 2}));
+
+    std::vector<StreamServerConfig> key = before;
+    key[0].key = "live/feed2";
+    CHECK(planServerReload(runningFrom(before), key) == (std::vector<size_t>{kNewServer, 1, 2}));
+
+    std::vector<StreamServerConfig> auth = before;
+    auth[2].authPass = "new-api-key";
+    CHECK(planServerReload(runningFrom(before), auth) == (std::vector<size_t>{0, 1, kNewServer}));
+
+    std::vector<StreamServerConfig> type = before;
+    type[2].type = ServerType::Mediamtx;
+    CHECK(planServerReload(runningFrom(before), type) == (std::vector<size_t>{0, 1, kNewServer}));
+
+    std::vector<StreamServerConfig> renamed = before;
+    renamed[0].name = "Main";
+    CHECK(planServerReload(runningFrom(before), renamed) == (std::vector<size_t>{kNewServer, 1, 2}));
+}
+
+void reorderKeepsByIdentity()
+{
+    std::vector<StreamServerConfig> before = baseline();
+    std::vector<StreamServerConfig> after = {before[2], before[0], before[1]};
+    CHECK(planServerReload(runningFrom(before), after) == (std::vector<size_t>{2, 0, 1}));
+}
+
+void addedAndRemovedServers()
+{
+    std::vector<StreamServerConfig> before = baseline();
+
+    std::vector<StreamServerConfig> added = before;
+    added.push_back(server("Extra", "http://10.0.0.9:8181/stats"));
+    CHECK(planServerReload(runningFrom(before), added) == (std::vector<size_t>{0, 1, 2, kNewServer}));
+
+    std::vector<StreamServerConfig> removed = {before[0], before[2]};
+    CHECK(planServerReload(runningFrom(before), removed) == (std::vector<size_t>{0, 2}));
+
+    std::vector<StreamServerConfig> disabled = before;
+    disabled[1].enabled = false;
+    CHECK(planServerReload(runningFrom(before), disabled) == (std::vector<size_t>{0, kNewServer, 2}));
+}
+
+// Two identical entries can't both take over the one running server
+void duplicatesKeepEachServerOnce()
+{
+    std::vector<StreamServerConfig> before = {server("Same", "http://10.0.0.1/stats")};
+    std::vector<StreamServerConfig> after = {before[0], before[0]};
+    CHECK(planServerReload(runningFrom(before), after) == (std::vector<size_t>{0, kNewServer}));
+
+    std::vector<StreamServerConfig> twoRunning = after;
+    CHECK(planServerReload(runningFrom(twoRunning), after) == (std::vector<size_t>{0, 1}));
+}
+
+void hashSeparatesFields()
+{
+    StreamServerConfig a = server("Primary", "http://host/stats");
+    StreamServerConfig b = a;
+    a.application = "ab";
+    a.key = "c";
+    b.application = "a";
+    b.key = "bc";
+    CHECK(hashServerConfig(a) != hashServerConfig(b));
+
+    StreamServerConfig c = a;
+    c.overrideScenes.enabled = true;
+    c.overrideScenes.normal = "Other";
+    c.priority = 9;
+    CHECK(hashServerConfig(a) == hashServerConfig(c));
+}
+
+} // anonymous namespace
+
+int main()
+{
+    unchangedConfigKeepsEverything();
+    sceneAndDependencyEditsKeep();
+    pollingEditsRebuildOnlyThatServer();
+    reorderKeepsByIdentity();
+    addedAndRemovedServers();
+    duplicatesKeepEachServerOnce();
+    hashSeparatesFields();
+    return TEST_RESULT();
+}
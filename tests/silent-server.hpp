@@ -0,0 +1,88 @@
+// A loopback server that accepts connections and then never says a word,
+// like a stats server or chat host that hangs after the TCP handshake.
+#pragma once
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+class SilentServer {
+public:
+    SilentServer()
+    {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t len = sizeof(addr);
+        if (fd_ < 0 || bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+            listen(fd_, 16) != 0 ||
+            getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &len) != 0) {
+            std::perror("silent server");
+            return;
+        }
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+        port_ = ntohs(addr.sin_port);
+        acceptThread_ = std::thread(&SilentServer::acceptLoop, this);
+    }
+
+    ~SilentServer()
+    {
+        running_ = false;
+        if (acceptThread_.joinable())
+            acceptThread_.join();
+        for (int client : clients_)
+            close(client);
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    std::string url(const char *scheme) const
+    {
+        return std::string(scheme) + "://127.0.0.1:" + std::to_string(port_) + "/stats";
+    }
+
+    int port() const { return port_; }
+    bool ok() const { return port_ != 0; }
+
+    // True once at least count connections have come in
+    bool waitForConnections(int count, std::chrono::milliseconds timeout) const
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (accepted_ < count && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return accepted_ >= count;
+    }
+
+private:
+    void acceptLoop()
+    {
+        while (running_) {
+            pollfd pfd{fd_, POLLIN, 0};
+            if (poll(&pfd, 1, 10) <= 0)
+                continue;
+            int client = accept(fd_, nullptr, nullptr);
+            if (client < 0)
+                continue;
+            clients_.push_back(client);
+            accepted_++;
+        }
+    }
+
+    int fd_ = -1;
+    int port_ = 0;
+    std::thread acceptThread_;
+    std::atomic<bool> running_{true};
+    std::atomic<int> accepted_{0};
+    std::vector<int> clients_; // accept thread only, then the destructor
+};
@@ -0,0 +1,20 @@
+// Just enough of the OBS frontend API for the switcher under test
+#pragma once
+
+#include "obs.h"
+
+struct obs_frontend_source_list {
+    struct {
+        obs_source_t **array;
+        size_t num;
+    } sources;
+};
+
+obs_source_t *obs_frontend_get_current_scene();
+void obs_frontend_set_current_scene(obs_source_t *scene);
+void obs_frontend_get_scenes(struct obs_frontend_source_list *sources);
+void obs_frontend_source_list_free(struct obs_frontend_source_list *source_list);
+void obs_frontend_streaming_start();
+void obs_frontend_streaming_stop();
+void obs_frontend_recording_start();
+void obs_frontend_recording_stop();
@@ -0,0 +1,24 @@
+// Just enough of libobs for the sources under test
+#pragma once
+
+#include "obs.h"
+#include <cstdarg>
+#include <cstdio>
+
+enum {
+    LOG_ERROR = 100,
+    LOG_WARNING = 200,
+    LOG_INFO = 300,
+    LOG_DEBUG = 400,
+};
+
+inline void blog(int level, const char *format, ...)
+{
+    if (level > LOG_WARNING)
+        return;
+    va_list args;
+    va_start(args, format);
+    std::vfprintf(stderr, format, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+}
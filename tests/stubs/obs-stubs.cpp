@@ -0,0 +1,61 @@
+// An OBS with one scene, "Live", and no sources or saved settings. Scene
+// switches and stream start/stop requests go nowhere.
+
+#include "obs.h"
+#include "obs-frontend-api.h"
+
+struct obs_source {
+    const char *name;
+};
+
+namespace {
+
+obs_source_t liveScene{"Live"};
+
+} // anonymous namespace
+
+void obs_queue_task(enum obs_task_type, obs_task_t task, void *param, bool)
+{
+    task(param);
+}
+
+void obs_enum_sources(bool (*)(void *, obs_source_t *), void *) {}
+obs_source_t *obs_get_source_by_name(const char *) { return nullptr; }
+const char *obs_source_get_name(const obs_source_t *source) { return source ? source->name : nullptr; }
+const char *obs_source_get_id(const obs_source_t *) { return "scene"; }
+obs_data_t *obs_source_get_settings(const obs_source_t *) { return nullptr; }
+void obs_source_media_restart(obs_source_t *) {}
+void obs_source_release(obs_source_t *) {}
+
+obs_data_t *obs_data_create() { return nullptr; }
+void obs_data_release(obs_data_t *) {}
+void obs_data_set_string(obs_data_t *, const char *, const char *) {}
+void obs_data_set_int(obs_data_t *, const char *, long long) {}
+void obs_data_set_bool(obs_data_t *, const char *, bool) {}
+void obs_data_set_array(obs_data_t *, const char *, obs_data_array_t *) {}
+const char *obs_data_get_string(obs_data_t *, const char *) { return ""; }
+long long obs_data_get_int(obs_data_t *, const char *) { return 0; }
+bool obs_data_get_bool(obs_data_t *, const char *) { return false; }
+obs_data_array_t *obs_data_get_array(obs_data_t *, const char *) { return nullptr; }
+bool obs_data_has_user_value(obs_data_t *, const char *) { return false; }
+
+obs_data_array_t *obs_data_array_create() { return nullptr; }
+void obs_data_array_release(obs_data_array_t *) {}
+size_t obs_data_array_count(obs_data_array_t *) { return 0; }
+obs_data_t *obs_data_array_item(obs_data_array_t *, size_t) { return nullptr; }
+size_t obs_data_array_push_back(obs_data_array_t *, obs_data_t *) { return 0; }
+
+obs_source_t *obs_frontend_get_current_scene() { return &liveScene; }
+void obs_frontend_set_current_scene(obs_source_t *) {}
+
+void obs_frontend_get_scenes(struct obs_frontend_source_list *sources)
+{
+    sources->sources.array = nullptr;
+    sources->sources.num = 0;
+}
+
+void obs_frontend_source_list_free(struct obs_frontend_source_list *) {}
+void obs_frontend_streaming_start() {}
+void obs_frontend_streaming_stop() {}
+void obs_frontend_recording_start() {}
+void obs_frontend_recording_stop() {}
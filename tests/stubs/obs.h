@@ -0,0 +1,46 @@
+// Just enough of libobs for the sources under test. The functions are
+// defined in obs-stubs.cpp, for the tests that link the switcher.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+typedef struct obs_data obs_data_t;
+typedef struct obs_data_array obs_data_array_t;
+typedef struct obs_source obs_source_t;
+
+enum obs_task_type {
+    OBS_TASK_UI,
+    OBS_TASK_GRAPHICS,
+    OBS_TASK_AUDIO,
+    OBS_TASK_DESTROY,
+};
+
+typedef void (*obs_task_t)(void *param);
+void obs_queue_task(enum obs_task_type type, obs_task_t task, void *param, bool wait);
+
+void obs_enum_sources(bool (*enum_proc)(void *, obs_source_t *), void *param);
+obs_source_t *obs_get_source_by_name(const char *name);
+const char *obs_source_get_name(const obs_source_t *source);
+const char *obs_source_get_id(const obs_source_t *source);
+obs_data_t *obs_source_get_settings(const obs_source_t *source);
+void obs_source_media_restart(obs_source_t *source);
+void obs_source_release(obs_source_t *source);
+
+obs_data_t *obs_data_create();
+void obs_data_release(obs_data_t *data);
+void obs_data_set_string(obs_data_t *data, const char *name, const char *val);
+void obs_data_set_int(obs_data_t *data, const char *name, long long val);
+void obs_data_set_bool(obs_data_t *data, const char *name, bool val);
+void obs_data_set_array(obs_data_t *data, const char *name, obs_data_array_t *array);
+const char *obs_data_get_string(obs_data_t *data, const char *name);
+long long obs_data_get_int(obs_data_t *data, const char *name);
+bool obs_data_get_bool(obs_data_t *data, const char *name);
+obs_data_array_t *obs_data_get_array(obs_data_t *data, const char *name);
+bool obs_data_has_user_value(obs_data_t *data, const char *name);
+
+obs_data_array_t *obs_data_array_create();
+void obs_data_array_release(obs_data_array_t *array);
+size_t obs_data_array_count(obs_data_array_t *array);
+obs_data_t *obs_data_array_item(obs_data_array_t *array, size_t idx);
+size_t obs_data_array_push_back(obs_data_array_t *array, obs_data_t *obj);
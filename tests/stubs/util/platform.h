@@ -0,0 +1,11 @@
+// Just enough of libobs for the sources under test
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+inline void os_sleep_ms(uint32_t duration)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+}
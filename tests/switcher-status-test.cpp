@@ -0,0 +1,81 @@
+// The UI, chat and websocket read the switcher's status and report scene
+// changes from their own threads. Neither may wait on the switcher or its
+// sampler, even while a stats server has accepted a poll and gone quiet.
+
+#include "check.hpp"
+#include "silent-server.hpp"
+#include "switcher.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace BitrateSwitch;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// generous for a loaded CI box; a call that waited on the hung poll would
+// take as long as the request timeout
+constexpr auto kCallBudget = std::chrono::milliseconds(5);
+
+void readsWhileServerHangs(const SilentServer &server)
+{
+    Config config;
+    config.lockWrite();
+    config.onlyWhenStreaming = false;
+    StreamServerConfig sls;
+    sls.type = ServerType::SrtLiveServer;
+    sls.name = "SLS";
+    sls.statsUrl = server.url("http");
+    sls.key = "live/feed1";
+    config.servers = {sls};
+    config.unlockWrite();
+
+    g_pluginAlive = true;
+    Switcher switcher(&config);
+    switcher.start();
+    CHECK(server.waitForConnections(1, std::chrono::milliseconds(2000)));
+    auto deadline = Clock::now() + std::chrono::milliseconds(2000);
+    while (switcher.getStatus()->version == 0 && Clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    CHECK(switcher.getStatus()->version > 0); // the switcher has ticked
+
+    // a UI thread of its own, as in OBS, polling like a UI timer would
+    auto worstStatus = Clock::duration::zero();
+    auto worstSceneChange = Clock::duration::zero();
+    std::thread ui([&] {
+        for (int i = 0; i < 250; i++) {
+            auto start = Clock::now();
+            std::shared_ptr<const SwitcherStatus> status = switcher.getStatus();
+            worstStatus = (std::max)(worstStatus, Clock::now() - start);
+            CHECK(status && status->serverCount == 1);
+            CHECK(!status->info.isOnline);
+
+            start = Clock::now();
+            switcher.onSceneChanged();
+            worstSceneChange = (std::max)(worstSceneChange, Clock::now() - start);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    });
+    ui.join();
+
+    CHECK(worstStatus < kCallBudget);
+    CHECK(worstSceneChange < kCallBudget);
+    switcher.stop();
+}
+
+} // anonymous namespace
+
+int main()
+{
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    SilentServer server;
+    CHECK(server.ok());
+    if (server.ok())
+        readsWhileServerHangs(server);
+
+    curl_global_cleanup();
+    return TEST_RESULT();
+}
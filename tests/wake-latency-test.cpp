@@ -0,0 +1,181 @@
+// stop() has to return promptly even when every server it talks to
+// accepts the connection and then never answers. The waits it cuts short
+// are a WsClient connect(), a PollEngine::run() and, all at once, whatever
+// a running Switcher has in flight; each must come back within 100 ms.
+//
+// The WsClient cases need libcurl 8 (WITH_WS_CLIENT), the Switcher case
+// also needs Qt (WITH_SWITCHER).
+
+#include "check.hpp"
+#include "poll-engine.hpp"
+#include "silent-server.hpp"
+#ifdef WITH_WS_CLIENT
+#include "ws-client.hpp"
+#endif
+#ifdef WITH_SWITCHER
+#include "switcher.hpp"
+#endif
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace BitrateSwitch;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr auto kWakeBudget = std::chrono::milliseconds(100);
+// long enough that the client is really stuck waiting on the server
+constexpr auto kHangBeforeWake = std::chrono::milliseconds(300);
+constexpr auto kConnectTimeout = std::chrono::milliseconds(2000);
+
+#ifdef WITH_WS_CLIENT
+void wsInterruptCutsConnectShort(const SilentServer &server)
+{
+    WsClient ws;
+    std::atomic<bool> returned{false};
+    Clock::time_point returnedAt;
+    bool connected = true;
+
+    std::thread worker([&] {
+        connected = ws.connect(server.url("ws"));
+        returnedAt = Clock::now();
+        returned = true;
+    });
+
+    std::this_thread::sleep_for(kHangBeforeWake);
+    CHECK(!returned); // still waiting on the handshake
+    auto wokenAt = Clock::now();
+    ws.interrupt();
+    worker.join();
+
+    CHECK(!connected);
+    CHECK(returnedAt - wokenAt < kWakeBudget);
+}
+
+// An owner may interrupt before its worker even starts connecting
+void wsInterruptSticksUntilCleared(const SilentServer &server)
+{
+    WsClient ws;
+    ws.interrupt();
+
+    auto start = Clock::now();
+    CHECK(!ws.connect(server.url("ws")));
+    CHECK(Clock::now() - start < kWakeBudget);
+
+    std::string message;
+    CHECK(ws.recv(message) == WsClient::RecvResult::Interrupted);
+    ws.clearInterrupt();
+}
+
+#endif // WITH_WS_CLIENT
+
+void pollEngineWakeupCutsRunShort(const SilentServer &server)
+{
+    PollEngine engine;
+    HttpRequest request;
+    request.url = server.url("http");
+    request.timeoutMs = 10000;
+
+    bool completed = false;
+    engine.submit({request}, [&](std::vector<HttpResponse> &&) { completed = true; });
+
+    // the sampler's loop: long waits until stop() clears running and
+    // wakes the engine
+    std::atomic<bool> running{true};
+    std::atomic<bool> returned{false};
+    Clock::time_point returnedAt;
+    std::thread poller([&] {
+        while (running)
+            engine.run(5000);
+        returnedAt = Clock::now();
+        returned = true;
+    });
+
+    std::this_thread::sleep_for(kHangBeforeWake);
+    CHECK(!returned);
+    auto wokenAt = Clock::now();
+    running = false;
+    engine.wakeup();
+    poller.join();
+
+    CHECK(returnedAt - wokenAt < kWakeBudget);
+    CHECK(!completed); // the server never answered
+    CHECK(engine.busy());
+}
+
+#ifdef WITH_SWITCHER
+// The sampler's HTTP poll, a RIST stats WebSocket and the chat connect
+// (IRC for Twitch, a WebSocket for Kick), all hanging when stop() comes
+void switcherStopCutsEverythingShort(ChatPlatform platform)
+{
+    SilentServer stats;
+    SilentServer rist;
+    SilentServer chat;
+    CHECK(stats.ok() && rist.ok() && chat.ok());
+
+    Config config;
+    config.lockWrite();
+    config.onlyWhenStreaming = false;
+
+    StreamServerConfig sls;
+    sls.type = ServerType::SrtLiveServer;
+    sls.name = "SLS";
+    sls.statsUrl = stats.url("http");
+    sls.key = "live/feed1";
+    StreamServerConfig ristServer;
+    ristServer.type = ServerType::Rist;
+    ristServer.name = "RIST";
+    ristServer.statsUrl = rist.url("ws");
+    config.servers = {sls, ristServer};
+
+    config.chat.enabled = true;
+    config.chat.platform = platform;
+    config.chat.channel = "channel";
+    config.chat.oauthToken = "oauth:token";
+    config.chat.kickChannelId = 1;
+    config.chat.kickChatroomId = 1;
+    config.chat.twitchIrcHost = "127.0.0.1";
+    config.chat.twitchIrcPort = chat.port();
+    config.chat.kickWsUrl = chat.url("ws");
+    config.unlockWrite();
+
+    g_pluginAlive = true;
+    Switcher switcher(&config);
+    switcher.start(); // the first tick connects chat
+
+    CHECK(stats.waitForConnections(1, kConnectTimeout));
+    CHECK(rist.waitForConnections(1, kConnectTimeout));
+    CHECK(chat.waitForConnections(1, kConnectTimeout));
+    std::this_thread::sleep_for(kHangBeforeWake);
+
+    auto begin = Clock::now();
+    switcher.stop();
+    CHECK(Clock::now() - begin < kWakeBudget);
+}
+#endif // WITH_SWITCHER
+
+} // anonymous namespace
+
+int main()
+{
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    SilentServer server;
+    CHECK(server.ok());
+    if (server.ok()) {
+#ifdef WITH_WS_CLIENT
+        wsInterruptCutsConnectShort(server);
+        wsInterruptSticksUntilCleared(server);
+#endif
+        pollEngineWakeupCutsRunShort(server);
+    }
+#ifdef WITH_SWITCHER
+    switcherStopCutsEverythingShort(ChatPlatform::Twitch);
+    switcherStopCutsEverythingShort(ChatPlatform::Kick);
+#endif
+
+    curl_global_cleanup();
+    return TEST_RESULT();
+}